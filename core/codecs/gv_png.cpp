@@ -5,11 +5,17 @@
 
 GV_NS_BEGIN
 
-PngCodec::decoder::decoder(File *file) :
+PngCodec::decoder::decoder(File *file, PixelFormat format, PixelDither dither, bool premultiply) :
 _file(file),
+_format(format),
+_dither(dither),
+_premultiply(premultiply),
 _png(),
 _info(),
-_endinfo() {}
+_endinfo(),
+_pixels(),
+_row(),
+_converter() {}
 
 PngCodec::decoder::~decoder() noexcept {
     if (_png) {
@@ -35,6 +41,7 @@ ptr<Image> PngCodec::decoder::load() noexcept {
     if (!(_endinfo = png_create_info_struct(_png))) {
         return nullptr;
     }
+    object<Image> image;
     if (setjmp(png_jmpbuf(_png))) {
         return nullptr;
     }
@@ -42,8 +49,8 @@ ptr<Image> PngCodec::decoder::load() noexcept {
     size_t rowbytes;
     int depth;
     int color;
+    int passes;
 
-    object<Image> image;
     png_set_read_fn(_png, this, callback);
     png_read_info(_png, _info);
     png_get_IHDR(_png, _info, &image->_width, &image->_height, &depth, &color, 0, 0, 0);
@@ -69,6 +76,7 @@ ptr<Image> PngCodec::decoder::load() noexcept {
     if (depth < 8) {
         png_set_packing(_png);
     }
+    passes = png_set_interlace_handling(_png);
     // update info
     png_read_update_info(_png, _info);
     depth = png_get_bit_depth(_png, _info);
@@ -91,29 +99,75 @@ ptr<Image> PngCodec::decoder::load() noexcept {
         return nullptr;
     }
     rowbytes = png_get_rowbytes(_png, _info);
-    size_t size = rowbytes * image->_height;
-    Chunk chunk(size);
+    // the rows are premultiplied in the png format, before converting
+    const PixelInfo *source = image->_pixelInfo.get();
+    bool premultiply = _premultiply && source->alpha();
 
-    if (!chunk.data()) {
-        return nullptr;
+    PixelInfo *target = image->_pixelInfo.get();
+    if (_format != PixelFormat::UNKNOWN && _format != target->format()) {
+        PixelInfo *info = PixelInfo::get(_format).get();
+        if (info->support() && target->convertible(_format)) {
+            target = info;
+        }
     }
-    Chunk tmp(sizeof(unsigned char*)* image->_height);
-    unsigned char **rows = (unsigned char**)tmp.data();
-    if (!rows) {
+
+    size_t pitch = (size_t)image->_width * target->pixelSize();
+    _pixels = object<Chunk>(pitch * image->_height);
+    if (!_pixels->data()) {
         return nullptr;
     }
-    for (unsigned i = 0; i < image->_height; i++) {
-        rows[i] = chunk.data() + i * rowbytes;
+    if (target == image->_pixelInfo) {
+        // every pass of an interlaced image fills in the rows read before
+        for (int pass = 0; pass < passes; ++pass) {
+            for (unsigned i = 0; i < image->_height; ++i) {
+                png_read_row(_png, _pixels->data() + i * rowbytes, nullptr);
+            }
+        }
+        if (premultiply) {
+            source->premultiply(_pixels->data(), (size_t)image->_width * image->_height);
+        }
+    }
+    else if (passes == 1) {
+        // converted a row at a time, the image is never held twice
+        _row = object<Chunk>(rowbytes);
+        if (!_row->data()) {
+            return nullptr;
+        }
+        _converter = new PixelConverter(image->_pixelInfo.get(), target->format(), image->_width, _dither);
+        for (unsigned i = 0; i < image->_height; ++i) {
+            png_read_row(_png, _row->data(), nullptr);
+            if (premultiply) {
+                source->premultiply(_row->data(), image->_width);
+            }
+            _converter->convert(_row->data(), _pixels->data() + i * pitch);
+        }
+    }
+    else {
+        // the passes of an interlaced image need it whole
+        _row = object<Chunk>(rowbytes * image->_height);
+        if (!_row->data()) {
+            return nullptr;
+        }
+        for (int pass = 0; pass < passes; ++pass) {
+            for (unsigned i = 0; i < image->_height; ++i) {
+                png_read_row(_png, _row->data() + i * rowbytes, nullptr);
+            }
+        }
+        if (premultiply) {
+            source->premultiply(_row->data(), (size_t)image->_width * image->_height);
+        }
+        image->_pixelInfo->convert(_row->data(), _pixels->data(), image->_width, image->_height, target->format(), _dither);
     }
-    png_read_image(_png, rows);
     png_read_end(_png, _endinfo);
 
-    image->_mipmaps.emplace_back(std::move(chunk));
+    image->_pixelInfo = target;
+    image->_pmAlpha = _premultiply;
+    image->_mipmaps.emplace_back(std::move(_pixels));
     return image;
 }
 
-ptr<Image> PngCodec::load(File *file) noexcept {
-    return decoder(file).load();
+ptr<Image> PngCodec::load(File *file, PixelFormat format, PixelDither dither, bool premultiply) noexcept {
+    return decoder(file, format, dither, premultiply).load();
 }
 
 GV_NS_END
@@ -3,6 +3,7 @@
 
 #include "gv_image.h"
 #include "gv_file.h"
+#include "gv_chunk.h"
 
 extern "C" {
 #include "png.h"
@@ -12,14 +13,27 @@ GV_NS_BEGIN
 
 class PngCodec final {
 public:
-    static ptr<Image> load(File *file) noexcept;
+    /**
+     * @brief Decodes file, converting each row to format as it's read
+     *        when the format is known and convertible, premultiplied
+     *        before.
+     */
+    static ptr<Image> load(File *file, PixelFormat format = PixelFormat::UNKNOWN, PixelDither dither = PixelDither::NONE,
+                           bool premultiply = false) noexcept;
 private:
     struct decoder {
         File *_file;
+        PixelFormat _format;
+        PixelDither _dither;
+        bool _premultiply;
         png_structp _png;
         png_infop _info;
         png_infop _endinfo;
-        decoder(File *file);
+        /* held here, a png error longjmps past the locals */
+        ptr<Chunk> _pixels;
+        ptr<Chunk> _row;
+        owned_ptr<PixelConverter> _converter;
+        decoder(File *file, PixelFormat format, PixelDither dither, bool premultiply);
         ~decoder();
         static void callback(png_structp png, png_bytep data, png_size_t size) noexcept;
         ptr<Image> load() noexcept;
@@ -0,0 +1,133 @@
+#include "opengxv.h"
+#include <cstring>
+#include <cstdlib>
+#include <zlib.h>
+#include "gv_archive.h"
+#include "gv_file.h"
+#include "gv_log.h"
+
+GV_NS_BEGIN
+
+Archive::Archive() noexcept
+: _header(),
+  _entries(),
+  _slots(),
+  _names()
+{ }
+
+ptr<Archive> Archive::open(const std::string &path) noexcept {
+    ptr<File> file = File::map(path, path);
+    if (!file) {
+        return nullptr;
+    }
+
+    size_t size = file->size();
+    const unsigned char *data = file->data();
+    if (size < sizeof(Header)) {
+        gv_error("'%s' isn't an archive.", path.c_str());
+        return nullptr;
+    }
+
+    const Header *header = (const Header*)data;
+    if (header->magic != MAGIC || header->version != VERSION) {
+        gv_error("'%s' isn't an archive.", path.c_str());
+        return nullptr;
+    }
+
+    // the entry table is bounded before its end is computed, a large
+    // offset or count would wrap around
+    if (header->entries < sizeof(Header) ||
+        header->entries > size ||
+        header->entries % sizeof(uint64_t) ||
+        header->count > (size - header->entries) / sizeof(Entry)) {
+        gv_error("archive '%s' is corrupted.", path.c_str());
+        return nullptr;
+    }
+
+    // the slot count is a power of 2 with at least one free slot
+    uint64_t slots = header->entries + (uint64_t)header->count * sizeof(Entry);
+    if (header->slots <= header->count ||
+        (header->slots & (header->slots - 1)) ||
+        slots + (uint64_t)header->slots * sizeof(uint32_t) > header->names ||
+        header->names > size) {
+        gv_error("archive '%s' is corrupted.", path.c_str());
+        return nullptr;
+    }
+
+    object<Archive> archive;
+    archive->_header = header;
+    archive->_entries = (const Entry*)(data + header->entries);
+    archive->_slots = (const uint32_t*)(data + slots);
+    archive->_names = (const char*)(data + header->names);
+    archive->_file = file;
+    return archive;
+}
+
+const Archive::Entry *Archive::find(const std::string &path) const noexcept {
+    hash64_t h = hash(path.data(), path.size());
+    size_t limit = _file->size() - _header->names;
+    unsigned mask = _header->slots - 1;
+    unsigned i = (unsigned)h & mask;
+    // a table without a free slot would never end the probe
+    for (unsigned n = _header->slots; n; --n, i = (i + 1) & mask) {
+        uint32_t index = _slots[i];
+        if (!index || index > _header->count) {
+            return nullptr;
+        }
+        const Entry *entry = _entries + index - 1;
+        if (entry->hash == h &&
+            entry->nameSize == path.size() &&
+            (uint64_t)entry->name + entry->nameSize <= limit &&
+            !std::memcmp(_names + entry->name, path.data(), path.size())) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+ptr<File> Archive::load(const std::string &path) noexcept {
+    const Entry *entry = find(path);
+    if (!entry) {
+        return nullptr;
+    }
+    // a stored entry is exposed with its size, which must then be the
+    // one of its payload; a deflated one is inflated into size + 1 bytes
+    bool deflated = entry->flags & DEFLATED;
+    if (entry->offset > _header->entries ||
+        entry->packedSize > _header->entries - entry->offset ||
+        (!deflated && entry->size != entry->packedSize) ||
+        (deflated && (entry->size >= (uint64_t)SIZE_MAX ||
+                      entry->size > (uLongf)-1 ||
+                      entry->packedSize > (uLong)-1))) {
+        gv_error("archive entry '%s' is corrupted.", path.c_str());
+        return nullptr;
+    }
+
+    object<File> file(path);
+    const unsigned char *packed = _file->data() + entry->offset;
+    if (!deflated) {
+        file->_data = const_cast<unsigned char*>(packed);
+        file->_size = (size_t)entry->size;
+        file->_archive = this;
+        return file;
+    }
+
+    unsigned char *data = (unsigned char*)std::malloc((size_t)entry->size + 1);
+    if (!data) {
+        gv_error("out of memory inflating archive entry '%s'.", path.c_str());
+        return nullptr;
+    }
+    uLongf size = (uLongf)entry->size;
+    if (uncompress(data, &size, packed, (uLong)entry->packedSize) != Z_OK || size != entry->size) {
+        gv_error("can't inflate archive entry '%s'.", path.c_str());
+        std::free(data);
+        return nullptr;
+    }
+    data[size] = '\0';
+    file->_data = data;
+    file->_size = (size_t)size;
+    return file;
+}
+
+GV_NS_END
+
@@ -0,0 +1,90 @@
+#ifndef __GV_ARCHIVE_H__
+#define __GV_ARCHIVE_H__
+
+#include <string>
+#include <cstdint>
+
+#include "gv_object.h"
+#include "gv_hash.h"
+
+GV_NS_BEGIN
+
+class File;
+
+/**
+ * @brief A read-only pack of files, mapped at once. The table of
+ *        contents is an open addressing hash table keyed by the path
+ *        of the files relative to the File root, the payloads are
+ *        aligned and may be deflated.
+ *
+ * Layout, little endian: the Header, the payloads, the Entry array,
+ * the slots (entry index + 1, 0 when free) and the names.
+ */
+class Archive : public SharedObject {
+    friend class Object;
+    friend class File;
+public:
+    enum {
+        MAGIC     = 0x4b505647, /* "GVPK" */
+        VERSION   = 1,
+        ALIGNMENT = 16,
+    };
+    enum {
+        DEFLATED  = 1,
+    };
+
+    struct Header {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t count;
+        std::uint32_t slots;
+        std::uint64_t entries;
+        std::uint64_t names;
+    };
+
+    struct Entry {
+        std::uint64_t hash;
+        std::uint64_t offset;
+        std::uint64_t size;
+        std::uint64_t packedSize;
+        std::uint32_t name;
+        std::uint32_t nameSize;
+        std::uint32_t flags;
+        std::uint32_t reserved;
+    };
+
+    static hash64_t hash(const char *path, size_t size) noexcept {
+        return hash64(path, size);
+    }
+
+    /**
+     * @brief Opens the archive at path, not relative to the File root.
+     *        Returns nullptr if it isn't a valid archive.
+     */
+    static ptr<Archive> open(const std::string &path) noexcept;
+
+    unsigned count() const noexcept {
+        return _header->count;
+    }
+    const Entry *find(const std::string &path) const noexcept;
+
+    /**
+     * @brief The file at path in the archive, a slice of the mapping
+     *        for a stored entry. nullptr if there isn't one.
+     */
+    ptr<File> load(const std::string &path) noexcept;
+
+private:
+    Archive() noexcept;
+
+    ptr<File>            _file;
+    const Header        *_header;
+    const Entry         *_entries;
+    const std::uint32_t *_slots;
+    const char          *_names;
+};
+
+GV_NS_END
+
+#endif
+
@@ -2,6 +2,7 @@
 #define __GV_CHUNK_H__
 
 #include <cstdlib>
+#include <cstring>
 #include "gv_object.h"
 
 GV_NS_BEGIN
@@ -10,20 +10,27 @@ DisplayObject::DisplayObject(bool iscontainer) noexcept
   _stage(),
   _iscontainer(iscontainer),
   _visible(true),
-  _matrixDirty(false)
+  _renderDirty(true),
+  _boundsDirty(),
+  _pathMask(),
+  _renderSegment()
 {
-    _matrix = new Matrix;
-    _matrix->setIdentity();
-    _concatenatedMatrix = new Matrix;
+    _transform = TransformPool::instance()->alloc(this);
+}
+
+DisplayObject::~DisplayObject() noexcept {
+    TransformPool::instance()->free(_transform);
 }
 
 static std::vector<ptr<DisplayObject>> __objects;
 
 Size2f DisplayObject::size() const {
+    const_cast<DisplayObject*>(this)->validateBounds();
     return _bounds.size();
 }
 
 void DisplayObject::size(const Size2f &value) {
+    validateBounds();
     if (_bounds.empty()) {
         return;
     }
@@ -33,8 +40,8 @@ void DisplayObject::size(const Size2f &value) {
     }
     float sx = value.width / boundsSize.width;
     float sy = value.height / boundsSize.height;
-    *_matrix = (*_matrix) * Scaling(sx, sy, 0.f);
-    _matrixDirty = true;
+    localMatrix() = localMatrix() * Scaling(sx, sy, 0.f);
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -55,16 +62,15 @@ void DisplayObject::height(float value) {
 }
 
 Vec3f DisplayObject::position() const {
-    return Vec3f(_matrix->translation());
+    return Vec3f(localMatrix().translation());
 }
 
 void DisplayObject::position(const Vec3f &value) {
-    auto pos = _matrix->translation();
+    auto pos = localMatrix().translation();
     if (pos != value) {
-        Vec3f d = value - position(); 
         pos = value;
-        _matrixDirty = true;
-        updateBounds(_bounds + Vec2f(d.x(), d.y()));
+        invalidateMatrix();
+        updateBounds();
     }
 }
 
@@ -73,12 +79,11 @@ float DisplayObject::x() const {
 }
 
 void DisplayObject::x(float value) {
-    auto pos = _matrix->translation();
+    auto pos = localMatrix().translation();
     if (pos.x() != value) {
-        float d = value - pos.x();
         pos.x() = value;
-        _matrixDirty = true;
-        updateBounds(_bounds + Vec2f(d, 0));
+        invalidateMatrix();
+        updateBounds();
     }
 }
 
@@ -87,12 +92,11 @@ float DisplayObject::y() const {
 }
 
 void DisplayObject::y(float value) {
-    auto pos = _matrix->translation();
+    auto pos = localMatrix().translation();
     if (pos.y() != value) {
-        float d = value - pos.y();
         pos.y() = value;
-        _matrixDirty = true;
-        updateBounds(_bounds + Vec2f(0, d));
+        invalidateMatrix();
+        updateBounds();
     }
 }
 
@@ -101,24 +105,24 @@ float DisplayObject::z() const {
 }
 
 void DisplayObject::z(float value) {
-    auto pos = _matrix->translation();
+    auto pos = localMatrix().translation();
     if (pos.z() != value) {
         pos.z() = value;
-        _matrixDirty = true;
+        invalidateMatrix();
     }
 }
 
 Vec3f DisplayObject::rotation() const {
     Vec3f rot;
-    math::matrixLinear(_matrix, &rot, nullptr);
+    math::matrixLinear(&localMatrix(), &rot, nullptr);
     return math::angle(rot);
 }
 
 void DisplayObject::rotation(const Vec3f &value) {
     Matrix3f scale;
-    math::matrixLinear(_matrix, (Vec3f*)nullptr, &scale);
-    _matrix->linear() = math::rotation(math::radian(value)) * scale;
-    _matrixDirty = true;
+    math::matrixLinear(&localMatrix(), (Vec3f*)nullptr, &scale);
+    localMatrix().linear() = math::rotation(math::radian(value)) * scale;
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -129,10 +133,10 @@ float DisplayObject::rotationX() const {
 void DisplayObject::rotationX(float value) {
     Vec3f rot;
     Matrix3f scale;
-    math::matrixLinear(_matrix, &rot, &scale);
+    math::matrixLinear(&localMatrix(), &rot, &scale);
     rot.x() = math::radian(value);
-    _matrix->linear() = math::rotation(rot) * scale;
-    _matrixDirty = true;
+    localMatrix().linear() = math::rotation(rot) * scale;
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -143,10 +147,10 @@ float DisplayObject::rotationY() const {
 void DisplayObject::rotationY(float value) {
     Vec3f rot;
     Matrix3f scale;
-    math::matrixLinear(_matrix, &rot, &scale);
+    math::matrixLinear(&localMatrix(), &rot, &scale);
     rot.y() = math::radian(value);
-    _matrix->linear() = math::rotation(rot) * scale;
-    _matrixDirty = true;
+    localMatrix().linear() = math::rotation(rot) * scale;
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -157,24 +161,24 @@ float DisplayObject::rotationZ() const {
 void DisplayObject::rotationZ(float value) {
     Vec3f rot;
     Matrix3f scale;
-    math::matrixLinear(_matrix, &rot, &scale);
+    math::matrixLinear(&localMatrix(), &rot, &scale);
     rot.z() = math::radian(value);
-    _matrix->linear() = math::rotation(rot) * scale;
-    _matrixDirty = true;
+    localMatrix().linear() = math::rotation(rot) * scale;
+    invalidateMatrix();
     updateBounds();
 }
 
 Vec3f DisplayObject::scale() const {
     Matrix3f m;
-    math::matrixLinear(_matrix, (Matrix3f*)nullptr, &m);
+    math::matrixLinear(&localMatrix(), (Matrix3f*)nullptr, &m);
     return Vec3f(m(0, 0), m(1, 1), m(2, 2));
 }
 
 void DisplayObject::scale(const Vec3f &value) {
     Matrix3f rot;
-    math::matrixLinear(_matrix, &rot, nullptr);
-    _matrix->linear() = rot * Scaling(value);
-    _matrixDirty = true;
+    math::matrixLinear(&localMatrix(), &rot, nullptr);
+    localMatrix().linear() = rot * Scaling(value);
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -184,9 +188,9 @@ float DisplayObject::scaleX() const {
 
 void DisplayObject::scaleX(float value) {
     Matrix3f rot;
-    math::matrixLinear(_matrix, &rot, nullptr);
-    _matrix->linear() = rot * Scaling(value, 0.f, 0.f);
-    _matrixDirty = true;
+    math::matrixLinear(&localMatrix(), &rot, nullptr);
+    localMatrix().linear() = rot * Scaling(value, 0.f, 0.f);
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -196,9 +200,9 @@ float DisplayObject::scaleY() const {
 
 void DisplayObject::scaleY(float value) {
     Matrix3f rot;
-    math::matrixLinear(_matrix, &rot, nullptr);
-    _matrix->linear() = rot * Scaling(0.f, value, 0.f);
-    _matrixDirty = true;
+    math::matrixLinear(&localMatrix(), &rot, nullptr);
+    localMatrix().linear() = rot * Scaling(0.f, value, 0.f);
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -208,9 +212,9 @@ float DisplayObject::scaleZ() const {
 
 void DisplayObject::scaleZ(float value) {
     Matrix3f rot;
-    math::matrixLinear(_matrix, &rot, nullptr);
-    _matrix->linear() = rot * Scaling(0.f, 0.f, value);
-    _matrixDirty = true;
+    math::matrixLinear(&localMatrix(), &rot, nullptr);
+    localMatrix().linear() = rot * Scaling(0.f, 0.f, value);
+    invalidateMatrix();
     updateBounds();
 }
 
@@ -219,67 +223,64 @@ bool DisplayObject::visible() const {
 }
 
 void DisplayObject::visible(bool value) {
-    _visible = value;
+    if (_visible != value) {
+        _visible = value;
+        invalidate();
+    }
 }
 
-inline void DisplayObject::updateBounds(const Box2f &bounds) noexcept {
+void DisplayObject::name(const ptr<UniStr> &value) noexcept {
+    if (_name == value) {
+        return;
+    }
+    ptr<UniStr> old = _name;
+    _name = value;
     if (_parent) {
-        _parent->updateChildBounds(this, _bounds, bounds);
+        _parent->renamed(this, old);
     }
-    _bounds = bounds;
 }
 
-void DisplayObject::updateBounds() {
-    updateBounds((*_matrix) * contentBounds());
+void DisplayObject::invalidate() noexcept {
+    // a culled object may still be marked from an earlier change, so
+    // always go on to the parent
+    _renderDirty = true;
+    for (DisplayObject *obj = _parent; obj && !obj->_renderDirty; obj = obj->_parent) {
+        obj->_renderDirty = true;
+    }
 }
 
-const Matrix &DisplayObject::concatenatedMatrix() noexcept {
-    size_t old_size = __objects.size();
-    DisplayObject *parent = _parent; 
-    size_t n = -1;
-    while (parent) {
-        __objects.emplace_back(parent);
-        if (parent->_matrixDirty) {
-            n = __objects.size();
-        }
-        parent = parent->_parent; 
+/* a dirty object always has its ancestors marked, the marking stops at
+ * the first one already done */
+void DisplayObject::invalidateBounds(unsigned char flags) noexcept {
+    _boundsDirty |= flags;
+    for (DisplayObject *obj = _parent; obj && !(obj->_boundsDirty & CHILDREN_BOUNDS_DIRTY); obj = obj->_parent) {
+        obj->_boundsDirty |= CHILDREN_BOUNDS_DIRTY;
     }
-    Matrix *trans;
-    if (n != (size_t)-1) {
-        DisplayObject *obj = __objects[n];
-        if (obj->_parent) {
-            *obj->_concatenatedMatrix = (*obj->_parent->_concatenatedMatrix) * (*obj->_matrix);
-            trans = obj->_concatenatedMatrix;
-        }
-        else {
-            trans = obj->_matrix;
-        }
-        for (--n; n <= old_size; --n) {
-            obj = __objects[n];
-            *obj->_concatenatedMatrix = (*trans) * (*obj->_matrix);
-            trans = obj->_concatenatedMatrix;
-        }
+}
+
+void DisplayObject::updateBounds() {
+    invalidateBounds(BOUNDS_DIRTY);
+    // what is culled may change too
+    invalidate();
+}
+
+void DisplayObject::validateBounds() noexcept {
+    if (!_boundsDirty) {
+        return;
     }
-    else {
-        if (!_parent) {
-            trans = _matrix;
-            goto finish;
-        }
-        if (!_matrixDirty) {
-            trans = _concatenatedMatrix;
-            goto finish;
-        }
-        trans = _parent->_concatenatedMatrix; 
+    if (_boundsDirty & CHILDREN_BOUNDS_DIRTY) {
+        static_cast<DisplayObjectContainer*>(this)->validateChildrenBounds();
     }
+    _boundsDirty = 0;
+    _bounds = localMatrix() * contentBounds();
+}
 
-    *_concatenatedMatrix = (*trans) * (*_matrix);
-    trans = _concatenatedMatrix;
-finish:
-    __objects.resize(old_size); 
-    return *trans; 
+Matrix DisplayObject::concatenatedMatrix() noexcept {
+    return TransformPool::instance()->concatenate(_transform);
 }
 
 Box2f DisplayObject::bounds(DisplayObject *targetCoordinateSpace) {
+    validateBounds();
     if (targetCoordinateSpace == _parent) {
         return _bounds;
     }
@@ -300,7 +301,38 @@ Box2f DisplayObject::bounds(DisplayObject *targetCoordinateSpace) {
     return contentBounds();
 }
 
+inline bool DisplayObject::listened(DisplayObject *parent, const ptr<UniStr> &type) const noexcept {
+    uint64_t mask = listenerMask() | (parent ? parent->_pathMask : 0);
+    return (mask & listenerBit(type)) != 0;
+}
+
+bool DisplayObject::willTrigger(const ptr<UniStr> &type) const noexcept {
+    return listened(_parent, type);
+}
+
+void DisplayObject::updatePathMask() noexcept {
+    uint64_t mask = listenerMask() | (_parent ? _parent->_pathMask : 0);
+    if (mask == _pathMask) {
+        return;
+    }
+    _pathMask = mask;
+    if (_iscontainer) {
+        for (auto child : static_cast<DisplayObjectContainer*>(this)->_container) {
+            child->updatePathMask();
+        }
+    }
+}
+
+void DisplayObject::listenersChanged() noexcept {
+    updatePathMask();
+}
+
 bool DisplayObject::dispatchEvent(DisplayObject *parent, ptr<Event> event) noexcept {
+    // nobody on the way listens, don't walk the ancestors
+    uint64_t mask = listenerMask() | (parent ? parent->_pathMask : 0);
+    if (!(mask & listenerBit(*event))) {
+        return false;
+    }
     size_t old_size = __objects.size();
     while (parent) {
         __objects.emplace_back(parent);
@@ -318,27 +350,25 @@ bool DisplayObject::dispatchEvent(ptr<Event> event) {
 void DisplayObject::stage(Stage *stage) {
     _stage = stage;
     if (stage) {
-        EventDispatcher::dispatchEvent(object<Event>(Event::ADD_TO_STAGE));
+        if (listened(nullptr, Event::ADD_TO_STAGE)) {
+            EventDispatcher::dispatchEvent(Event::obtain(Event::ADD_TO_STAGE));
+        }
     }
-    else {
-        EventDispatcher::dispatchEvent(object<Event>(Event::REMOVED_FROM_STAGE));
+    else if (listened(nullptr, Event::REMOVED_FROM_STAGE)) {
+        EventDispatcher::dispatchEvent(Event::obtain(Event::REMOVED_FROM_STAGE));
     }
 }
 
-void DisplayObject::render(Renderer &renderer, const Matrix &mat, int dirty) noexcept {
+void DisplayObject::render(Renderer &renderer) noexcept {
+    _renderDirty = false;
     if (!_visible) {
         return;
     }
-    dirty |= (int)_matrixDirty; 
-    if (dirty) {
-        *_concatenatedMatrix = mat * (*_matrix);
-        _matrixDirty = false;
-    }
-    if (!_stage->checkVisibility((*_concatenatedMatrix) * _bounds)) {
+    if (!_stage->checkVisibility(TransformPool::instance()->transform(_parent->_transform, _bounds))) {
         return;
     }
 
-    draw(renderer, *_concatenatedMatrix);
+    draw(renderer, worldMatrix());
 }
 
 GV_NS_END
@@ -7,6 +7,8 @@
 #include "gv_log.h"
 #include "gv_eventdispatcher.h"
 #include "gv_renderer.h"
+#include "gv_transformpool.h"
+#include "gv_ranktree.h"
 
 GV_NS_BEGIN
 
@@ -18,6 +20,7 @@ class DisplayObject : public EventDispatcher {
     friend class DisplayObjectContainer;
     friend class InteractiveObject;
     friend class Stage;
+    friend class TransformPool;
     GV_FRIEND_LIST();
 public:
     virtual Size2f size() const;
@@ -72,16 +75,14 @@ public:
         return _name;
     }
 
-    void name(const ptr<UniStr> &value) noexcept {
-        _name = value;
-    }
+    void name(const ptr<UniStr> &value) noexcept;
 
     void name(const char *value) noexcept {
-        _name = unistr(value);
+        name(unistr(value));
     }
 
     void name(const std::string &value) noexcept {
-        _name = unistr(value);
+        name(unistr(value));
     }
 
     DisplayObjectContainer *parent() const noexcept {
@@ -92,50 +93,90 @@ public:
         return _stage;
     }
 
-    Matrix &matrix() noexcept {
-        return *_matrix;
+    /**
+     * @brief A copy, the matrices live in the TransformPool arrays
+     *        which move as objects come and go. Changes are written
+     *        back with matrix(const Matrix&).
+     */
+    Matrix matrix() noexcept {
+        return localMatrix();
     }
 
     void matrix(const Matrix &mat) noexcept {
-        const Matrix *m = std::addressof<const Matrix>(mat);
-        if (!m){
-            return;
-        }
-        if (m != _matrix){
-            *_matrix = mat;
-        }
-        _matrixDirty = true;
+        localMatrix() = mat;
+        invalidateMatrix();
         updateBounds();
     }
 
-    const Matrix &concatenatedMatrix() noexcept;
+    Matrix concatenatedMatrix() noexcept;
     virtual Box2f bounds(DisplayObject *targetCoordinateSpace);
     virtual bool dispatchEvent(ptr<Event> event) override;
+    /**
+     * @brief False when no listener for type is registered on the
+     *        object or its ancestors, true when there may be one.
+     */
+    bool willTrigger(const ptr<UniStr> &type) const noexcept;
 
 protected:
     DisplayObject() noexcept : DisplayObject(false) { }
+    ~DisplayObject() noexcept;
     virtual Box2f contentBounds() = 0;
+    /**
+     * @brief The content or the matrix changed, the bounds are 
+     *        recomputed when next needed.
+     */
     virtual void updateBounds();
     virtual void draw(Renderer &renderer, const Matrix &mat) = 0;
+    /**
+     * @brief Marks what draw() emits as changed, so the retained
+     *        render caches of the containers above are rebuilt.
+     */
+    void invalidate() noexcept;
+    virtual void listenersChanged() noexcept override;
 
 private:
     DisplayObject(bool iscontainer) noexcept;
-    void updateBounds(const Box2f &bounds) noexcept;
+    void invalidateBounds(unsigned char flags) noexcept;
+    void validateBounds() noexcept;
     bool dispatchEvent(DisplayObject *parent, ptr<Event> event) noexcept;
+    bool listened(DisplayObject *parent, const ptr<UniStr> &type) const noexcept;
+    void updatePathMask() noexcept;
     virtual void stage(Stage *stage);
-    void render(Renderer &renderer, const Matrix &mat, int dirty) noexcept;
+    void render(Renderer &renderer) noexcept;
+    /* only valid until the next TransformPool alloc() or update() */
+    Matrix &localMatrix() noexcept {
+        return TransformPool::instance()->local(_transform);
+    }
+    const Matrix &localMatrix() const noexcept {
+        return TransformPool::instance()->local(_transform);
+    }
+    Matrix worldMatrix() const noexcept {
+        return TransformPool::instance()->world(_transform);
+    }
+    void invalidateMatrix() noexcept {
+        TransformPool::instance()->dirty(_transform);
+        invalidate();
+    }
 
 private:
+    enum {
+        BOUNDS_DIRTY            = 1,
+        CHILDREN_BOUNDS_DIRTY   = 2,
+    };
+
     clist_entry             _entry;
+    ranktree::node          _order;
     DisplayObjectContainer *_parent;
     Stage                  *_stage;
     ptr<UniStr>             _name;
-    owned_ptr<Matrix>       _matrix;
-    owned_ptr<Matrix>       _concatenatedMatrix;
+    unsigned                _transform;
     Box2f                   _bounds;
     bool                    _iscontainer;
     bool                    _visible;
-    bool                    _matrixDirty;
+    bool                    _renderDirty;
+    unsigned char           _boundsDirty;
+    uint64_t                _pathMask;      // the listener masks up to the root
+    unsigned                _renderSegment;
 }; 
 
 GV_NS_END
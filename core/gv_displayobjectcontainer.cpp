@@ -4,23 +4,103 @@
 
 GV_NS_BEGIN
 
-DisplayObjectContainer::DisplayObjectContainer() noexcept : InteractiveObject(true)
+DisplayObjectContainer::DisplayObjectContainer() noexcept 
+: InteractiveObject(true),
+  _culling(false),
+  _indexState(INDEX_REBUILD)
 { }
 
+void DisplayObjectContainer::Container::insert(DisplayObject *child, DisplayObject *before) noexcept {
+    if (_ranked) {
+        _ranks.insert(&child->_order, before ? _ranks.index(&before->_order) : _ranks.size());
+    }
+    if (before) {
+        ContainerBase::insert_front(before, child);
+    }
+    else {
+        push_back(child);
+    }
+}
+
+/* the caller keeps a reference, the one of the list is dropped */
+void DisplayObjectContainer::Container::remove(DisplayObject *child) noexcept {
+    if (_ranked) {
+        _ranks.remove(&child->_order);
+    }
+    ContainerBase::remove(child);
+}
+
+DisplayObject *DisplayObjectContainer::Container::at(unsigned index) noexcept {
+    if (_ranked) {
+        ranktree::node *n = _ranks.at(index);
+        return n ? containerof_member(n, &DisplayObject::_order) : nullptr;
+    }
+
+    // walk from the nearest end
+    if (index < _size / 2) {
+        for (DisplayObject *child = first(); child; child = next(child)) {
+            if (!index--) {
+                return child;
+            }
+        }
+    }
+    else if (index < _size) {
+        index = _size - 1 - index;
+        for (DisplayObject *child = last(); child; child = prev(child)) {
+            if (!index--) {
+                return child;
+            }
+        }
+    }
+    return nullptr;
+}
+
+unsigned DisplayObjectContainer::Container::index(DisplayObject *which) noexcept {
+    if (_ranked) {
+        return _ranks.index(&which->_order);
+    }
+
+    unsigned n = 0;
+    for (DisplayObject *child = first(); child; child = next(child)) {
+        if (child == which) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+void DisplayObjectContainer::Container::ranked(bool value) noexcept {
+    if (value == _ranked) {
+        return;
+    }
+    _ranked = value;
+    _ranks.clear();
+    if (value) {
+        for (DisplayObject *child = first(); child; child = next(child)) {
+            _ranks.insert(&child->_order, _ranks.size());
+        }
+    }
+}
+
+DisplayObjectContainer::~DisplayObjectContainer() noexcept {
+    for (auto child : _container) {
+        child->_parent = nullptr;
+        child->updatePathMask();
+        TransformPool::instance()->detach(child->_transform);
+    }
+}
+
 DisplayObject *DisplayObjectContainer::addChild(const ptr<DisplayObject> &child, DisplayObject *before) {
     gv_assert(child, "child is null.");
     gv_assert(!before || before->_parent == this, "before is not contains by the container.");
 
+    childrenChanged();
     if (child->_parent) {
         if (child->_parent == this) {
             if (child != before) {
-                Container::remove(child); 
-                if (before) {
-                    Container::insert_front(before, child);
-                }
-                else {
-                    _container.push_back(child);
-                }
+                _container.remove(child);
+                _container.insert(child, before);
             }
             return child;
         }
@@ -28,20 +108,16 @@ DisplayObject *DisplayObjectContainer::addChild(const ptr<DisplayObject> &child,
     }
 
     child->_parent = this;
-    child->_matrixDirty = true;
+    child->updatePathMask();
+    namesAdded(child);
+    TransformPool::instance()->attach(child->_transform, _transform);
+    child->invalidateMatrix();
     ++_container._size;
-
-    if (before) {
-        Container::insert_front(before, child);
-    }
-    else {
-        _container.push_back(child);
-    }
-
-    if (!child->_bounds.empty()) {
-        updateChildBounds(child, Box2f(), child->_bounds); 
+    _container.insert(child, before);
+    invalidateBounds(CHILDREN_BOUNDS_DIRTY);
+    if (child->willTrigger(Event::ADDED)) {
+        child->dispatchEvent(Event::obtain(Event::ADDED, true));
     }
-    child->dispatchEvent(object<Event>(Event::ADDED, true)); 
     if (_stage) {
         child->stage(_stage);
     }
@@ -53,21 +129,28 @@ DisplayObject *DisplayObjectContainer::addChild(const ptr<DisplayObject> &child)
 }
 
 DisplayObject *DisplayObjectContainer::addChild(const ptr<DisplayObject> &child, unsigned index) {
-    return addChild(child, getChildAt(index));
+    gv_assert(index <= _container._size, "index out of range.");
+    return addChild(child, _container.at(index));
 }
 
 ptr<DisplayObject> DisplayObjectContainer::removeChild(const ptr<DisplayObject> &child, bool update) {
     gv_assert(child, "child is null.");
     gv_assert(child->_parent == this, "child is not contains by the container.");
     --_container._size; 
-    Container::remove(child);
+    _container.remove(child);
+    namesRemoved(child);
     child->_parent = nullptr;
+    child->updatePathMask();
+    TransformPool::instance()->detach(child->_transform);
+    childrenChanged();
 
-    if (update && !child->_bounds.empty()) {
-        updateChildBounds(child, child->_bounds, Box2f()); 
+    if (update) {
+        invalidateBounds(CHILDREN_BOUNDS_DIRTY);
     }
 
-    child->dispatchEvent(this, object<Event>(Event::REMOVED, true));
+    if (child->listened(this, Event::REMOVED)) {
+        child->dispatchEvent(this, Event::obtain(Event::REMOVED, true));
+    }
     if (_stage) {
         child->stage(nullptr);
     }
@@ -84,13 +167,10 @@ ptr<DisplayObject> DisplayObjectContainer::removeChild(unsigned index) {
 
 void DisplayObjectContainer::removeChildren() {
     ptr<DisplayObject> child;
-    while ((child = _container.pop_front())) {
+    while ((child = _container.first())) {
         removeChild(child, false);
     }
-    if (!_childrenBounds.empty()) {
-        _childrenBounds.setZero();
-        updateBounds();
-    }
+    invalidateBounds(CHILDREN_BOUNDS_DIRTY);
 }
 
 void DisplayObjectContainer::swapChildren(const ptr<DisplayObject> &a, const ptr<DisplayObject> &b) {
@@ -101,20 +181,22 @@ void DisplayObjectContainer::swapChildren(const ptr<DisplayObject> &a, const ptr
         return;
     }
 
-    DisplayObject *next = _container.next(a); 
-    if (next == b) {
-        Container::remove(a);
-        Container::insert_back(b, a);
+    childrenChanged();
+    DisplayObject *next_a = _container.next(a);
+    DisplayObject *next_b = _container.next(b);
+    if (next_a == b) {
+        _container.remove(a);
+        _container.insert(a, next_b);
     }
-    else if (_container.prev(a) == b) {
-        Container::remove(b);
-        Container::insert_back(a, b);
+    else if (next_b == a) {
+        _container.remove(b);
+        _container.insert(b, next_a);
     }
     else {
-        Container::remove(a);
-        Container::insert_back(b, a);
-        Container::remove(b);
-        Container::insert_front(next, b);
+        _container.remove(a);
+        _container.insert(a, next_b);
+        _container.remove(b);
+        _container.insert(b, next_a);
     }
 }
 
@@ -123,56 +205,150 @@ void DisplayObjectContainer::swapChildren(unsigned a, unsigned b) {
         return;
     }
 
-    if (a < b) {
-        std::swap(a, b);
-    }
+    gv_assert(a < _container._size && b < _container._size, "child index out of range.");
+    swapChildren(_container.at(a), _container.at(b));
+}
 
-    gv_assert(a < _container._size, "child index out of range.");
+unsigned DisplayObjectContainer::getChildIndex(DisplayObject *which) {
+    gv_assert(which->_parent == this, "child is not contains by the container.");
+    return _container.index(which);
+}
 
-    DisplayObject *child_a = nullptr, *child_b = nullptr;
-    unsigned n = 0;
-    for (auto child : _container) {
-        if (n == b) {
-            child_b = child;
-        }
-        if (n == a) {
-            child_a = child;
-            break;
+void DisplayObjectContainer::setChildIndex(DisplayObject *child, unsigned index) {
+    addChild(child, index);
+}
+
+DisplayObject *DisplayObjectContainer::getChildAt(unsigned index) {
+    gv_assert(index < _container._size, "index out of range.");
+    return _container.at(index);
+}
+
+static inline void insertName(std::unordered_multimap<UniStr*, DisplayObject*> &index, UniStr *name, DisplayObject *obj) {
+    if (name) {
+        index.emplace(name, obj);
+    }
+}
+
+static inline void eraseName(std::unordered_multimap<UniStr*, DisplayObject*> &index, UniStr *name, DisplayObject *obj) {
+    if (!name) {
+        return;
+    }
+    auto range = index.equal_range(name);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second == obj) {
+            index.erase(it);
+            return;
         }
-        n++;
     }
+}
 
-    swapChildren(child_a, child_b);
+/* visits obj and all its descendants */
+template <typename _Fn>
+void DisplayObjectContainer::visitSubtree(DisplayObject *obj, const _Fn &fn) {
+    fn(obj);
+    if (obj->_iscontainer) {
+        for (auto child : static_cast<DisplayObjectContainer*>(obj)->_container) {
+            visitSubtree(child, fn);
+        }
+    }
 }
 
-unsigned DisplayObjectContainer::getChildIndex(DisplayObject *which) {
-    gv_assert(which->_parent == this, "child is not contains by the container.");
+void DisplayObjectContainer::namesAdded(DisplayObject *child) noexcept {
+    insertName(_names, child->_name, child);
+    for (DisplayObjectContainer *c = this; c; c = c->_parent) {
+        if (c->_subtreeNames) {
+            NameIndex &index = *c->_subtreeNames;
+            visitSubtree(child, [&index](DisplayObject *obj) {
+                insertName(index, obj->_name, obj);
+            });
+        }
+    }
+}
 
-    unsigned n = 0;
-    for (auto child : _container) {
-        if (child == which) {
-            break;
+void DisplayObjectContainer::namesRemoved(DisplayObject *child) noexcept {
+    eraseName(_names, child->_name, child);
+    for (DisplayObjectContainer *c = this; c; c = c->_parent) {
+        if (c->_subtreeNames) {
+            NameIndex &index = *c->_subtreeNames;
+            visitSubtree(child, [&index](DisplayObject *obj) {
+                eraseName(index, obj->_name, obj);
+            });
         }
-        n++;
     }
-    return n;
 }
 
-void DisplayObjectContainer::setChildIndex(DisplayObject *child, unsigned index) {
-    addChild(child, index);
+void DisplayObjectContainer::renamed(DisplayObject *child, UniStr *oldName) noexcept {
+    eraseName(_names, oldName, child);
+    insertName(_names, child->_name, child);
+    for (DisplayObjectContainer *c = this; c; c = c->_parent) {
+        if (c->_subtreeNames) {
+            eraseName(*c->_subtreeNames, oldName, child);
+            insertName(*c->_subtreeNames, child->_name, child);
+        }
+    }
 }
 
-DisplayObject *DisplayObjectContainer::getChildAt(unsigned index) {
-    gv_assert(index < _container._size, "index out of range.");
+void DisplayObjectContainer::subtreeNameIndex(bool value) noexcept {
+    if (value == subtreeNameIndex()) {
+        return;
+    }
+    if (!value) {
+        _subtreeNames = nullptr;
+        return;
+    }
+    _subtreeNames = new NameIndex;
+    NameIndex &index = *_subtreeNames;
     for (auto child : _container) {
-        if (!index--) {
-            return child;
+        visitSubtree(child, [&index](DisplayObject *obj) {
+            insertName(index, obj->_name, obj);
+        });
+    }
+}
+
+/* whether a comes before b in a depth-first walk of the container */
+bool DisplayObjectContainer::precedes(DisplayObject *a, DisplayObject *b) noexcept {
+    auto depth = [this](DisplayObject *obj) {
+        unsigned n = 0;
+        for (; obj != this; obj = obj->_parent) {
+            ++n;
         }
+        return n;
+    };
+    unsigned da = depth(a), db = depth(b);
+    bool deeper = da > db;
+    for (; da > db; --da) {
+        a = a->_parent;
     }
-    return nullptr;
+    for (; db > da; --db) {
+        b = b->_parent;
+    }
+    if (a == b) {
+        // one is an ancestor of the other, which is visited first
+        return !deeper;
+    }
+    while (a->_parent != b->_parent) {
+        a = a->_parent;
+        b = b->_parent;
+    }
+    return a->_parent->getChildIndex(a) < a->_parent->getChildIndex(b);
 }
 
 DisplayObject *DisplayObjectContainer::getChildByName(UniStr *name, bool recursive) {
+    if (name) {
+        NameIndex *index = recursive ? (NameIndex*)_subtreeNames : &_names;
+        if (index) {
+            // a name may be shared, the first in order wins
+            auto range = index->equal_range(name);
+            DisplayObject *found = nullptr;
+            for (auto it = range.first; it != range.second; ++it) {
+                if (!found || precedes(it->second, found)) {
+                    found = it->second;
+                }
+            }
+            return found;
+        }
+    }
+
     for (auto child : _container) {
         if (child->_name == name) {
             return child;
@@ -205,68 +381,261 @@ bool DisplayObjectContainer::contains(DisplayObject *which) {
 void DisplayObjectContainer::bringChildToFront(const ptr<DisplayObject> &child) {
     gv_assert(child->_parent == this, "child is not contains by the container.");
 
-    Container::remove(child);
-    _container.push_back(child);
+    _container.remove(child);
+    _container.insert(child, nullptr);
+    childrenChanged();
 }
 
 void DisplayObjectContainer::sendChildToBack(const ptr<DisplayObject> &child) {
     gv_assert(child->_parent == this, "child is not contains by the container.");
 
-    Container::remove(child);
-    _container.push_front(child);
+    _container.remove(child);
+    _container.insert(child, _container.first());
+    childrenChanged();
 }
 
 Box2f DisplayObjectContainer::contentBounds() {
     return _childrenBounds;
 }
 
-void DisplayObjectContainer::updateChildBounds(DisplayObject *which, const Box2f &oldBounds, const Box2f &newBounds) {
+/* recomputes the dirty children bounds and their union, bottom-up */
+void DisplayObjectContainer::validateChildrenBounds() noexcept {
     Box2f bounds;
+    bool changed = false;
+    for (auto child : _container) {
+        if (child->_boundsDirty) {
+            Box2f old = child->_bounds;
+            child->validateBounds();
+            changed = changed || old != child->_bounds;
+        }
+        bounds |= child->_bounds;
+    }
+    _childrenBounds = bounds;
+    if (changed && _indexState == INDEX_VALID) {
+        _indexState = INDEX_REFIT;
+    }
+}
+
+void DisplayObjectContainer::stage(Stage *stage) {
+    DisplayObject::stage(stage);
+    for (auto child : _container) {
+        child->stage(stage);
+    }
+}
+
+void DisplayObjectContainer::spatialIndex(bool value) noexcept {
+    if (value == spatialIndex()) {
+        return;
+    }
+    if (value) {
+        _spatialIndex = new SpatialIndex;
+        _indexState = INDEX_REBUILD;
+    }
+    else {
+        _spatialIndex = nullptr;
+        _indexed.clear();
+        _indexedBounds.clear();
+    }
+}
+
+void DisplayObjectContainer::updateSpatialIndex() noexcept {
+    if (_indexState == INDEX_VALID) {
+        return;
+    }
+    if (_indexState == INDEX_REBUILD) {
+        // the indices of the visible children are stale
+        _culling = false;
+        _indexed.clear();
+        for (auto child : _container) {
+            _indexed.emplace_back(child);
+        }
+    }
+    _indexedBounds.clear();
+    for (auto child : _indexed) {
+        _indexedBounds.emplace_back(child->_bounds);
+    }
+    if (_indexState == INDEX_REBUILD) {
+        _spatialIndex->build(_indexedBounds.data(), (unsigned)_indexedBounds.size());
+    }
+    else {
+        _spatialIndex->refit(_indexedBounds.data(), (unsigned)_indexedBounds.size());
+    }
+    _indexState = INDEX_VALID;
+}
 
-    if (oldBounds.empty() || oldBounds.inside(_bounds)) {
-        bounds = _childrenBounds | newBounds;
+/* point is in the space of the children bounds */
+void DisplayObjectContainer::objectsUnderPoint(const Vec2f &point, std::vector<ptr<DisplayObject>> &result) noexcept {
+    auto test = [&point, &result](DisplayObject *child) {
+        if (!child->_visible || !child->_bounds.contains(point)) {
+            return;
+        }
+        if (!child->_iscontainer) {
+            result.emplace_back(child);
+            return;
+        }
+        const Matrix &mat = child->localMatrix();
+        Vec2f local;
+        if (Matrix2D::flat(mat)) {
+            local = Matrix2D(mat).inverse() * point;
+        }
+        else {
+            Vec3f v = mat.inverse() * Vec3f(point.x(), point.y(), 0.f);
+            local = Vec2f(v.x(), v.y());
+        }
+        static_cast<DisplayObjectContainer*>(child)->objectsUnderPoint(local, result);
+    };
+
+    if (_spatialIndex) {
+        updateSpatialIndex();
+        std::vector<unsigned> hits;
+        _spatialIndex->query(point, hits);
+        for (auto index : hits) {
+            test(_indexed[index]);
+        }
     }
     else {
         for (auto child : _container) {
-            const Box2f &childBounds = child == which ? newBounds : child->_bounds;
-            _childrenBounds |= childBounds;
+            test(child);
         }
     }
+}
+
+std::vector<ptr<DisplayObject>> DisplayObjectContainer::getObjectsUnderPoint(const Vec2f &point) {
+    validateBounds();
+    DisplayObject *root = this;
+    while (root->_parent) {
+        root = root->_parent;
+    }
+    Vec3f global = root->localMatrix() * Vec3f(point.x(), point.y(), 0.f);
+    Vec2f local;
+    TransformPool *pool = TransformPool::instance();
+    pool->concatenate(_transform);
+    if (pool->flat(_transform)) {
+        local = pool->flatWorld(_transform).inverse() * Vec2f(global.x(), global.y());
+    }
+    else {
+        Vec3f v = pool->world(_transform).inverse() * global;
+        local = Vec2f(v.x(), v.y());
+    }
+
+    std::vector<ptr<DisplayObject>> result;
+    objectsUnderPoint(local, result);
+    return result;
+}
 
-    if (bounds != _childrenBounds) {
-        _childrenBounds = bounds;
-        updateBounds();
+inline void DisplayObjectContainer::renderChild(Renderer &renderer, DisplayObject *child, bool reuse) noexcept {
+    Renderer::Mark mark = renderer.mark();
+    unsigned first = _renderCache.size();
+    unsigned index = child->_renderSegment;
+    if (reuse && !child->_renderDirty && index < _lastSegments.size() && _lastSegments[index].object == child) {
+        renderer.replay(_lastRenderCache, _lastSegments[index].first, _lastSegments[index].count);
+    }
+    else if (child->_iscontainer) {
+        static_cast<DisplayObjectContainer*>(child)->render(renderer);
+    }
+    else {
+        child->render(renderer);
+    }
+    if (renderer.record(mark, _renderCache)) {
+        child->_renderSegment = (unsigned)_segments.size();
+        _segments.emplace_back(child, first, _renderCache.size() - first);
     }
 }
 
-void DisplayObjectContainer::stage(Stage *stage) {
-    DisplayObject::stage(stage);
+/* a subtree out of the rendering misses the changes of its transforms,
+ * the caches in it are dropped and rebuilt when it's back */
+void DisplayObjectContainer::invalidateRenderCache() noexcept {
+    _renderCache.invalidate();
     for (auto child : _container) {
-        child->stage(stage);
+        if (child->_iscontainer) {
+            static_cast<DisplayObjectContainer*>(child)->invalidateRenderCache();
+        }
+    }
+}
+
+/* a subtree already dropped isn't walked again */
+void DisplayObjectContainer::culled(DisplayObject *child) noexcept {
+    if (child->_iscontainer) {
+        DisplayObjectContainer *container = static_cast<DisplayObjectContainer*>(child);
+        if (container->_renderCache.valid()) {
+            container->invalidateRenderCache();
+        }
     }
 }
 
-void DisplayObjectContainer::render(Renderer &renderer, const Matrix &mat, int dirty) noexcept {
+/* drops the children the spatial index query has culled since the last
+ * rebuild of the cache, both lists are in ascending order */
+void DisplayObjectContainer::cullChildren() noexcept {
+    auto visible = _visibleChildren.begin();
+    auto end = _visibleChildren.end();
+    if (_culling) {
+        for (auto index : _lastVisibleChildren) {
+            while (visible != end && *visible < index) {
+                ++visible;
+            }
+            if (visible == end || *visible != index) {
+                culled(_indexed[index]);
+            }
+        }
+    }
+    else {
+        for (unsigned index = 0; index < _indexed.size(); ++index) {
+            if (visible != end && *visible == index) {
+                ++visible;
+            }
+            else {
+                culled(_indexed[index]);
+            }
+        }
+    }
+    _culling = true;
+}
+
+void DisplayObjectContainer::render(Renderer &renderer) noexcept {
+    bool renderDirty = _renderDirty;
+    _renderDirty = false;
     if (!_visible) {
+        culled(this);
         return;
     }
-    dirty |= (int)_matrixDirty; 
-    if (dirty) {
-        *_concatenatedMatrix = mat * (*_matrix);
-        _matrixDirty = false;
-    }
-    if (!_stage->checkVisibility((*_concatenatedMatrix) * _bounds)) {
+    TransformPool *pool = TransformPool::instance();
+    if (!_stage->checkVisibility(pool->transform(_parent->_transform, _bounds))) {
+        culled(this);
         return;
     }
 
-    draw(renderer, *_concatenatedMatrix);
+    bool dirty = pool->changed(_transform);
+    if (!dirty && !renderDirty && _renderCache.valid()) {
+        renderer.replay(_renderCache);
+        return;
+    }
 
-    for (ptr<DisplayObject> child : _container) {
-        if (child->_iscontainer) {
-            static_cast<DisplayObjectContainer*>(child.get())->render(renderer, *_concatenatedMatrix, dirty);
+    // rebuild the cache, the segments of the children that haven't changed
+    // are copied from the last one, only dirty subtrees are traversed.
+    _renderCache.swap(_lastRenderCache);
+    _segments.swap(_lastSegments);
+    _renderCache.clear();
+    _segments.clear();
+    bool reuse = !dirty && _lastRenderCache.valid();
+
+    Renderer::Mark mark = renderer.mark();
+    draw(renderer, worldMatrix());
+    renderer.record(mark, _renderCache);
+
+    if (_spatialIndex && pool->flat(_transform)) {
+        updateSpatialIndex();
+        _visibleChildren.swap(_lastVisibleChildren);
+        _visibleChildren.clear();
+        _spatialIndex->query(pool->flatWorld(_transform).inverse() * _stage->viewport(), _visibleChildren);
+        cullChildren();
+        for (auto index : _visibleChildren) {
+            renderChild(renderer, _indexed[index], reuse);
         }
-        else {
-            child->render(renderer, *_concatenatedMatrix, dirty);
+    }
+    else {
+        _culling = false;
+        for (ptr<DisplayObject> child : _container) {
+            renderChild(renderer, child, reuse);
         }
     }
 }
@@ -1,7 +1,10 @@
 #ifndef __GV_DISPLAY_OBJECT_CONTAINER_H__
 #define __GV_DISPLAY_OBJECT_CONTAINER_H__
 
+#include <unordered_map>
+
 #include "gv_interactiveobject.h"
+#include "gv_spatialindex.h"
 
 GV_NS_BEGIN
 
@@ -9,6 +12,7 @@ class DisplayObjectContainer : public InteractiveObject {
     friend class Object;
     friend class DisplayObject;
     friend class Stage;
+    friend class TransformPool;
 public:
     typedef gv_list(ptr<DisplayObject>, _entry) ContainerBase;
     class Container : private ContainerBase {
@@ -33,9 +37,17 @@ public:
         using ContainerBase::crend;
         Container& operator=(const Container&) = delete;
     protected:
-        Container() noexcept : _size() {}
+        Container() noexcept : _size(), _ranked() {}
     private:
+        void insert(DisplayObject *child, DisplayObject *before) noexcept;
+        void remove(DisplayObject *child) noexcept;
+        DisplayObject *at(unsigned index) noexcept;
+        unsigned index(DisplayObject *child) noexcept;
+        void ranked(bool value) noexcept;
+
         unsigned _size;
+        ranktree _ranks;
+        bool     _ranked;
     };
 
     virtual DisplayObject *addChild(const ptr<DisplayObject> &child);
@@ -63,19 +75,108 @@ public:
     virtual void bringChildToFront(const ptr<DisplayObject> &child);
     virtual void sendChildToBack(const ptr<DisplayObject> &child);
 
+    /**
+     * @brief Keeps the children in an order-statistic tree besides the
+     *        list, getChildAt(), getChildIndex() and the index based 
+     *        insertions become O(log n) instead of a walk.
+     */
+    void indexedChildren(bool value) noexcept {
+        _container.ranked(value);
+    }
+    bool indexedChildren() const noexcept {
+        return _container._ranked;
+    }
+
+    /**
+     * @brief Also indexes the names of all the descendants, so that a
+     *        recursive getChildByName() is a hash lookup. Every change
+     *        below the container then updates the index.
+     */
+    void subtreeNameIndex(bool value) noexcept;
+    bool subtreeNameIndex() const noexcept {
+        return _subtreeNames != nullptr;
+    }
+
+    /**
+     * @brief Enables a bounding volume hierarchy over the children 
+     *        bounds, used to cull them and to hit-test them. Worth 
+     *        it for many children that seldom move, like the tiles 
+     *        of a scrolling map.
+     */
+    void spatialIndex(bool value) noexcept;
+    bool spatialIndex() const noexcept {
+        return _spatialIndex != nullptr;
+    }
+
+    /**
+     * @brief The descendants, containers excepted, whose bounds 
+     *        contain point (in stage coordinates), back to front.
+     */
+    std::vector<ptr<DisplayObject>> getObjectsUnderPoint(const Vec2f &point);
+
 protected:
     DisplayObjectContainer() noexcept;
-    virtual void updateChildBounds(DisplayObject *child, const Box2f &oldBounds, const Box2f &newBounds);
+    ~DisplayObjectContainer() noexcept;
     virtual Box2f contentBounds() override;
 
 private:
     ptr<DisplayObject> removeChild(const ptr<DisplayObject> &child, bool update);
     virtual void stage(Stage *stage) override;
-    void render(Renderer &renderer, const Matrix &mat, int dirty) noexcept;
+    void render(Renderer &renderer) noexcept;
+    void renderChild(Renderer &renderer, DisplayObject *child, bool reuse) noexcept;
+    void invalidateRenderCache() noexcept;
+    static void culled(DisplayObject *child) noexcept;
+    void cullChildren() noexcept;
+    void childrenChanged() noexcept {
+        invalidate();
+        _indexState = INDEX_REBUILD;
+    }
+    void validateChildrenBounds() noexcept;
+    void updateSpatialIndex() noexcept;
+    void namesAdded(DisplayObject *child) noexcept;
+    void namesRemoved(DisplayObject *child) noexcept;
+    void renamed(DisplayObject *child, UniStr *oldName) noexcept;
+    bool precedes(DisplayObject *a, DisplayObject *b) noexcept;
+    template <typename _Fn>
+    static void visitSubtree(DisplayObject *obj, const _Fn &fn);
+    void objectsUnderPoint(const Vec2f &point, std::vector<ptr<DisplayObject>> &result) noexcept;
 
 private:
-    Box2f _childrenBounds;
-    Container _container;
+    enum {
+        INDEX_VALID,
+        INDEX_REFIT,
+        INDEX_REBUILD,
+    };
+
+    typedef std::unordered_multimap<UniStr*, DisplayObject*> NameIndex;
+
+    /* the part of the render cache a child emitted */
+    struct Segment {
+        Segment(DisplayObject *obj, unsigned start, unsigned n) noexcept
+        : object(obj), first(start), count(n) {}
+
+        DisplayObject *object;
+        unsigned       first;
+        unsigned       count;
+    };
+
+    Box2f                       _childrenBounds;
+    Container                   _container;
+    RenderCache                 _renderCache;
+    RenderCache                 _lastRenderCache;
+    std::vector<Segment>        _segments;
+    std::vector<Segment>        _lastSegments;
+    owned_ptr<SpatialIndex>     _spatialIndex;
+    std::vector<DisplayObject*> _indexed;
+    std::vector<Box2f>          _indexedBounds;
+    std::vector<unsigned>       _visibleChildren;
+    std::vector<unsigned>       _lastVisibleChildren;
+    /* whether _lastVisibleChildren are the indexed children the last
+     * rebuild of the cache rendered */
+    bool                        _culling;
+    int                         _indexState;
+    NameIndex                   _names;
+    owned_ptr<NameIndex>        _subtreeNames;
 };
 
 GV_NS_END
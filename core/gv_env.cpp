@@ -4,9 +4,18 @@
 GV_NS_BEGIN
 
 Env::Env() : 
-    defaultPixelFormat(PixelFormat::RGBA8888) {
+    defaultPixelFormat(PixelFormat::RGBA8888),
+    autoPixelFormat(true),
+    pixelErrorBound(0),
+    pixelDither(PixelDither::ORDERED),
+    premultiplyAlpha(true),
+    _glVersion(),
+    _maxTextureSize(2048) {
     //_glVersion = atof((const char*)glGetString(GL_VERSION));
-    //glGetIntegerv(GL_MAX_TEXTURE_SIZE, &_maxTextureSize);
+    // the stage made the context current, a headless one has none
+    if (!Stage::headless()) {
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &_maxTextureSize);
+    }
 }
 
 
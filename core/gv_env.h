@@ -18,7 +18,23 @@ public:
     float glVersion() const noexcept {
         return _glVersion;
     }
+    /**
+     * @brief format, or the default one if format is UNKNOWN and
+     *        autoPixelFormat is off. UNKNOWN stays when it's on.
+     */
+    PixelFormat pixelFormat(PixelFormat format) const noexcept {
+        return format != PixelFormat::UNKNOWN || autoPixelFormat ? format : defaultPixelFormat;
+    }
     PixelFormat defaultPixelFormat;
+    /* textures of no given format take the smallest one fitting their
+     * pixels within pixelErrorBound, see PixelInfo::smallest() */
+    bool autoPixelFormat;
+    unsigned pixelErrorBound;
+    /* how conversions to the 16 bits formats round */
+    PixelDither pixelDither;
+    /* images are decoded with their colors premultiplied by alpha, the
+     * textures of them blend without dark fringes */
+    bool premultiplyAlpha;
 private:
     Env();
     float _glVersion;
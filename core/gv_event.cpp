@@ -1,9 +1,25 @@
 #include "opengxv.h"
+#include <vector>
 #include "gv_event.h"
 #include "gv_log.h"
 
 GV_NS_BEGIN
 
+/* the released events, kept with no reference */
+static struct EventPool {
+    static constexpr size_t capacity = 64;
+
+    ~EventPool() {
+        closed = true;
+        for (auto event : events) {
+            ptr<Event> tmp(event);
+        }
+    }
+
+    std::vector<Event*> events;
+    bool                closed = false;
+} __eventPool;
+
 GV_IMPL_UNISTR(Event, ACTIVATE);
 GV_IMPL_UNISTR(Event, ADDED);
 GV_IMPL_UNISTR(Event, ADD_TO_STAGE);
@@ -22,7 +38,8 @@ Event::Event(const ptr<UniStr> &type, bool bubbles, bool cancelable) noexcept
   _isDefaultPrevented(false),
   _cancelable(cancelable), 
   _bubbles(bubbles),
-  _eventPhase(EventPhase::AT_TARGET)
+  _eventPhase(EventPhase::AT_TARGET),
+  _pooled(false)
 { }
 
 Event::Event(const char *type, bool bubbles, bool cancelable) noexcept 
@@ -41,7 +58,36 @@ Event::Event(const Event &x) noexcept
   _isDefaultPrevented(false),
   _cancelable(x._cancelable), 
   _bubbles(x._bubbles),
-  _eventPhase(EventPhase::AT_TARGET)
+  _eventPhase(EventPhase::AT_TARGET),
+  _pooled(false)
 { }
 
+ptr<Event> Event::obtain(const ptr<UniStr> &type, bool bubbles, bool cancelable) noexcept {
+    if (__eventPool.events.empty()) {
+        ptr<Event> event = object<Event>(type, bubbles, cancelable);
+        event->_pooled = true;
+        return event;
+    }
+    Event *event = __eventPool.events.back();
+    __eventPool.events.pop_back();
+    event->_type = type;
+    event->_stop = StopType::NONE;
+    event->_isDefaultPrevented = false;
+    event->_cancelable = cancelable;
+    event->_bubbles = bubbles;
+    event->_eventPhase = EventPhase::AT_TARGET;
+    return event;
+}
+
+bool Event::recycle() noexcept {
+    if (!_pooled || __eventPool.closed || __eventPool.events.size() >= EventPool::capacity) {
+        return false;
+    }
+    _type = nullptr;
+    _target = nullptr;
+    _currentTarget = nullptr;
+    __eventPool.events.emplace_back(this);
+    return true;
+}
+
 GV_NS_END
@@ -21,8 +21,14 @@ public:
     Event(const std::string &type, bool bubbles = false, bool cancelable = false) noexcept;
     Event(const Event &x) noexcept;
 
+    /**
+     * @brief An Event from a free list of released ones, allocates only
+     *        when it is empty. For the main thread.
+     */
+    static ptr<Event> obtain(const ptr<UniStr> &type, bool bubbles = false, bool cancelable = false) noexcept;
+
     virtual ptr<Event> clone() {
-        return object<Event>(*this);
+        return obtain(_type, _bubbles, _cancelable);
     }
 
     ptr<Object> target() const noexcept {
@@ -67,6 +73,19 @@ public:
         _stop = StopType::STOP;
     }
 
+    /**
+     * @brief Folds next, a later event of the same class and type 
+     *        queued for the same target, into this one. Returns false 
+     *        to have both delivered. Events carrying data that the 
+     *        listeners need one by one must override it.
+     */
+    virtual bool coalesce(const Event &next) noexcept {
+        return true;
+    }
+
+protected:
+    virtual bool recycle() noexcept override;
+
 private:
     enum class StopType {
         NONE,
@@ -82,6 +101,7 @@ private:
     bool        _cancelable;
     bool        _bubbles;
     EventPhase  _eventPhase;
+    bool        _pooled;
 
 public:
     /**
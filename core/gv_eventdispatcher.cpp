@@ -1,6 +1,8 @@
 #include "opengxv.h"
 
 #include <vector>
+#include <algorithm>
+#include <typeinfo>
 #include "gv_eventdispatcher.h"
 #include "gv_log.h"
 
@@ -8,50 +10,64 @@ GV_NS_BEGIN
 
 EventListenerStub::~EventListenerStub() noexcept {
     if (_dispatcher) {
-        _dispatcher->_map.erase(this);
+        EventDispatcher *dispatcher = _dispatcher;
+        auto it = dispatcher->_map.find(_name);
+        auto &phases = it->second._phases;
+        auto &listeners = phases[_capture];
+        listeners.erase(std::find(listeners.begin(), listeners.end(), this));
+        if (!phases[0].empty() || !phases[1].empty()) {
+            return;
+        }
+        dispatcher->_map.erase(it);
+
+        // the bit may be shared by other types still listened
+        unsigned slot = EventDispatcher::listenerSlot(_name);
+        for (auto &entry : dispatcher->_map) {
+            if (EventDispatcher::listenerSlot(entry.first) == slot) {
+                return;
+            }
+        }
+        dispatcher->_listenerMask &= ~((uint64_t)1 << slot);
+        dispatcher->listenersChanged();
     }
 }
 
 /* EventDispatcher */
 EventDispatcher::~EventDispatcher() noexcept {
-    _map.clear([](EventListenerStub *stub) {
-        stub->_dispatcher = nullptr;
-    });
+    for (auto &entry : _map) {
+        for (auto &listeners : entry.second._phases) {
+            for (auto stub : listeners) {
+                stub->_dispatcher = nullptr;
+            }
+        }
+    }
 }
 
-ptr<EventListenerStub> EventDispatcher::addEventListener(ptr<EventListenerStub> &stub) noexcept {
-    _map.emplace(*stub, [=](){ return stub; });
+ptr<EventListenerStub> EventDispatcher::addEventListener(const ptr<EventListenerStub> &stub) noexcept {
+    auto &listeners = _map[stub->_name]._phases[stub->_capture];
+    int priority = stub->_priority;
+    listeners.emplace(
+        std::upper_bound(listeners.begin(), listeners.end(), priority, 
+            [](int priority, const EventListenerStub *x) { 
+                return priority > x->_priority; 
+            }),
+        stub);
+
+    uint64_t bit = listenerBit(stub->_name);
+    if (!(_listenerMask & bit)) {
+        _listenerMask |= bit;
+        listenersChanged();
+    }
     return stub;
 }
 
 inline  bool EventDispatcher::dispatchEvent(ptr<Event> &event, bool cap) {
-    int capture = cap ? 0 : 1;
-    EventListenerStub *stub = nullptr;
-    _map.find(
-        event->_type,
-        [&](const ptr<UniStr> &lhs, const EventListenerStub &rhs) noexcept {
-            if (stub) {
-                if (lhs != rhs._name || capture != rhs._capture) {
-                    return 0;
-                }
-                else {
-                    stub = (EventListenerStub*)std::addressof<const EventListenerStub>(rhs);
-                }
-            }
-            else {
-                int n;
-                if ((n = lhs - rhs._name)) {
-                    return n;
-                }
-                if ((n = capture - rhs._capture)) {
-                    return n;
-                }
-                stub = (EventListenerStub*)std::addressof<const EventListenerStub>(rhs);
-            }
-            return -1;
-        });
-
-    if (!stub) {
+    auto it = _map.find(event->_type);
+    if (it == _map.end()) {
+        return true;
+    }
+    auto &listeners = it->second._phases[cap ? 0 : 1];
+    if (listeners.empty()) {
         return true;
     }
 
@@ -64,16 +80,20 @@ inline  bool EventDispatcher::dispatchEvent(ptr<Event> &event, bool cap) {
         ptr<EventListenerStub> _stub;
         ptr<Object> _holder;
     };
+
+    // listeners may add or remove listeners, the ones called are those 
+    // registered when the dispatch started, kept alive until it ends.
+    // a listener may also dispatch, hence the indices.
     static std::vector<context> ctxs;
     size_t old_size = ctxs.size();
-    do {
+    for (auto stub : listeners) {
         ctxs.emplace_back(stub, stub->_holder);
-        stub = map_type::next(stub);
-    } while (stub && stub->_name == event->_type && stub->_capture == capture); 
+    }
+    size_t size = ctxs.size();
 
     event->_currentTarget = this; 
-    for (auto &ctx : ctxs) {
-        (*ctx._stub)(event);
+    for (size_t i = old_size; i < size; ++i) {
+        (*ctxs[i]._stub)(event);
         if (event->_stop == Event::StopType::IMMEDIATE) {
             break;
         }
@@ -131,7 +151,50 @@ bool EventDispatcher::dispatchEvent(ptr<Event> event,
     return event->isDefaultPrevented(); 
 }
 
+struct QueuedEvent {
+    QueuedEvent(EventDispatcher *target, ptr<Event> &&event) noexcept :
+        _target(target),
+        _event(std::move(event)) {}
+
+    ptr<EventDispatcher> _target;
+    ptr<Event>           _event;
+};
+
+static std::vector<QueuedEvent> __queue;
+
+void EventDispatcher::queueEvent(ptr<Event> event) noexcept {
+    for (auto &queued : __queue) {
+        if (queued._target == this && 
+            queued._event->_type == event->_type &&
+            typeid(*queued._event) == typeid(*event) &&
+            queued._event->coalesce(*event)) {
+            return;
+        }
+    }
+    __queue.emplace_back(this, std::move(event));
+}
+
+void EventDispatcher::flushEvents() {
+    if (__queue.empty()) {
+        return;
+    }
+    std::vector<QueuedEvent> queue;
+    queue.swap(__queue);
+    for (auto &queued : queue) {
+        queued._target->dispatchEvent(queued._event);
+    }
+
+    // keeps the storage, the queue is refilled every frame
+    queue.clear();
+    if (__queue.empty()) {
+        __queue.swap(queue);
+    }
+}
+
 bool EventDispatcher::dispatchEvent(ptr<Event> event) {
+    if (!(_listenerMask & listenerBit(event->_type))) {
+        return false;
+    }
     if (event->_target) {
         event = event->clone();
     }
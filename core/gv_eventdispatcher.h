@@ -1,8 +1,9 @@
 #ifndef __GV_EVENT_DISPATCHER_H__
 #define __GV_EVENT_DISPATCHER_H__
 
+#include <vector>
+#include <unordered_map>
 #include "gv_object.h"
-#include "gv_rbmap.h"
 #include "gv_event.h"
 
 GV_NS_BEGIN
@@ -22,7 +23,6 @@ class EventListenerStub : public Object {
     ~EventListenerStub() noexcept;
     virtual void operator ()(ptr<Event>&) noexcept = 0;
 
-    map_entry        _entry;
     EventDispatcher *_dispatcher;
     Object          *_holder;
     ptr<UniStr>      _name;
@@ -45,6 +45,7 @@ class EventDispatcher : public Object {
             _functor(std::forward<_F>(functor)){ }
     };
 public:
+    EventDispatcher() noexcept : _listenerMask() {}
     ~EventDispatcher() noexcept;
 
     template <typename _Functor>
@@ -80,30 +81,67 @@ public:
                  void (_T::*func)(Event&), 
                  bool useCapture, 
                  int priority) noexcept :
-                EventListenerStub(this, name, holder, useCapture, priority),
+                EventListenerStub(dispatcher, name, holder, useCapture, priority),
                 _func(func) { }
         };
         return addEventListener(object<Stub>(this, name, holder, func, useCapture, priority));
     }
 
     virtual bool dispatchEvent(ptr<Event> event);
+
+    /**
+     * @brief Queues event for the next flushEvents(). An event of the 
+     *        same class and type already queued for this dispatcher 
+     *        absorbs it instead, see Event::coalesce().
+     */
+    void queueEvent(ptr<Event> event) noexcept;
+    /**
+     * @brief Dispatches the queued events in order, the Stage calls it
+     *        once per frame. The events queued meanwhile wait for the
+     *        next flush.
+     */
+    static void flushEvents();
 protected:
     bool dispatchEvent(ptr<Event> event, const ptr<EventDispatcher> &target, const ptr<EventDispatcher> *dispatchers, unsigned count);
 
+    /**
+     * @brief The bit of type in the listener masks. The masks are a 
+     *        one-hash bloom filter: a clear bit means no listener.
+     */
+    static unsigned listenerSlot(const UniStr *type) noexcept {
+        return (unsigned)(type->hash() & 63);
+    }
+    static unsigned listenerSlot(const ptr<UniStr> &type) noexcept {
+        return listenerSlot(type.get());
+    }
+    static uint64_t listenerBit(const ptr<UniStr> &type) noexcept {
+        return (uint64_t)1 << listenerSlot(type);
+    }
+    static uint64_t listenerBit(const Event &event) noexcept {
+        return listenerBit(event._type);
+    }
+    uint64_t listenerMask() const noexcept {
+        return _listenerMask;
+    }
+    /**
+     * @brief Called after the listener mask changed.
+     */
+    virtual void listenersChanged() noexcept {}
+
 private:
     bool dispatchEvent(ptr<Event> &event, bool cap);
-    ptr<EventListenerStub> addEventListener(ptr<EventListenerStub> &stub) noexcept;
+    ptr<EventListenerStub> addEventListener(const ptr<EventListenerStub> &stub) noexcept;
 
 private:
-    struct compare {
-        int operator()(const EventListenerStub &lhs, const EventListenerStub &rhs) const noexcept {
-            return lhs._name < rhs._name ||
-                   lhs._capture < rhs._capture ||
-                   lhs._priority > rhs._priority ? -1 : 1;
-        }
+    /* the listeners of one type, per phase (capture first), sorted by 
+     * decreasing priority then by registration order */
+    struct Listeners {
+        std::vector<EventListenerStub*> _phases[2];
     };
-    typedef gv_map(EventListenerStub, EventListenerStub, _entry, compare) map_type;
+    typedef std::unordered_map<UniStr*, Listeners> map_type;
     map_type _map;
+    /* the bits of the types in _map */
+    uint64_t _listenerMask;
 };
 
 GV_NS_END
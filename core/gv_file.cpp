@@ -1,6 +1,17 @@
 #include "opengxv.h"
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#if defined(WIN32) || defined(__MINGW32__)
 #include "windows.h"
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "gv_file.h"
+#include "gv_archive.h"
 
 GV_NS_BEGIN
 #include "gv_filetype.inl"
@@ -10,23 +21,35 @@ FileType File::type(const char *str, size_t size) noexcept {
 }
 
 std::string File::_root("data/");
+std::vector<ptr<Archive>> File::_archives;
 
-File::File(const ptr<Path> &path) noexcept : _path(path->tostring()), _data(), _size() {
+File::File(const std::string &path) noexcept : _path(path), _data(), _size(), _pos(), _mapped() {
 }
 
 File::~File() noexcept {
-    if (_data) {
+    // a stored archive entry is a slice of the archive mapping
+    if (!_data || _archive) {
+        return;
+    }
+#if defined(WIN32) || defined(__MINGW32__)
+    std::free(_data);
+#else
+    if (_mapped) {
+        munmap(_data, _size);
+    }
+    else {
         std::free(_data);
     }
+#endif
 }
 
-ptr<File> File::load(const ptr<Path> &path) noexcept {
+#if defined(WIN32) || defined(__MINGW32__)
+ptr<File> File::map(const std::string &path, const std::string &fullPath) noexcept {
     object<File> file(path);
 
     size_t size = 0;
 
     WCHAR wszBuf[4096] = { 0 };
-    std::string fullPath = _root + file->_path;
     MultiByteToWideChar(CP_UTF8, 0, fullPath.c_str(), -1, wszBuf, sizeof(wszBuf) / sizeof(wszBuf[0]));
 
     HANDLE handle = ::CreateFileW(wszBuf, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
@@ -50,6 +73,64 @@ ptr<File> File::load(const ptr<Path> &path) noexcept {
     file->_pos = 0;
     return file;
 }
+#else
+ptr<File> File::map(const std::string &path, const std::string &fullPath) noexcept {
+    object<File> file(path);
+
+    int fd = ::open(fullPath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    // an empty file can't be mapped, it keeps no data
+    if (st.st_size > 0) {
+        void *data = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            return nullptr;
+        }
+        file->_data = (unsigned char*)data;
+        file->_size = (size_t)st.st_size;
+        file->_mapped = true;
+#if defined(POSIX_MADV_SEQUENTIAL)
+        posix_madvise(data, file->_size, POSIX_MADV_SEQUENTIAL);
+#endif
+    }
+    ::close(fd);
+    return file;
+}
+#endif
+
+ptr<File> File::load(const std::string &path) noexcept {
+    for (auto it = _archives.rbegin(); it != _archives.rend(); ++it) {
+        ptr<File> file = (*it)->load(path);
+        if (file) {
+            return file;
+        }
+    }
+    return map(path, _root + path);
+}
+
+ptr<Archive> File::mount(const std::string &path) noexcept {
+    ptr<Archive> archive = Archive::open(path);
+    if (archive) {
+        _archives.emplace_back(archive);
+    }
+    return archive;
+}
+
+void File::unmount(Archive *archive) noexcept {
+    auto it = std::find(_archives.begin(), _archives.end(), archive);
+    if (it != _archives.end()) {
+        _archives.erase(it);
+    }
+}
 
 int File::read(void *buf, size_t size) noexcept {
     if (_pos + size > _size) {
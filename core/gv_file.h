@@ -1,12 +1,15 @@
 #ifndef __GV_FILE_H__
 #define __GV_FILE_H__
 
+#include <vector>
 #include "gv_platform.h"
 #include "gv_unistr.h"
 #include "gv_path.h"
 
 GV_NS_BEGIN
 
+class Archive;
+
 enum class FileType {
     IMAGE_BEGIN,
     PNG = IMAGE_BEGIN,
@@ -31,6 +34,7 @@ enum class FileType {
 
 class File : public Object {
     friend class Object;
+    friend class Archive;
 public:
     static FileType type(const char *str, size_t size = 0) noexcept;
     static FileType type(const std::string &name) noexcept {
@@ -45,12 +49,30 @@ public:
     static void root(const std::string &path) noexcept {
         _root = path;
     }
-    static ptr<File> load(const ptr<Path> &path) noexcept;
+    static ptr<File> load(const ptr<Path> &path) noexcept {
+        return load(path->tostring());
+    }
+    /**
+     * @brief Loads the file at path, relative to root(), from the last
+     *        mounted archive which has it, else from the file system.
+     *        May run on any thread.
+     */
+    static ptr<File> load(const std::string &path) noexcept;
+    /**
+     * @brief Mounts the archive at path, not relative to root(). From 
+     *        the main thread while no load is running.
+     */
+    static ptr<Archive> mount(const std::string &path) noexcept;
+    static void unmount(Archive *archive) noexcept;
 public:
     ~File() noexcept;
     size_t size() const noexcept {
         return _size;
     }
+    /**
+     * @brief The content, read-only. Mapped from the page cache where
+     *        the platform allows it, it isn't '\0' terminated then.
+     */
     const unsigned char *data() const noexcept {
         return _data;
     }
@@ -59,13 +81,17 @@ public:
     }
     int read(void *buf, size_t size) noexcept;
 private:
-    File(const ptr<Path> &path) noexcept;
+    File(const std::string &path) noexcept;
+    static ptr<File> map(const std::string &path, const std::string &fullPath) noexcept;
 private:
     static std::string _root;
+    static std::vector<ptr<Archive>> _archives;
     std::string _path;
     unsigned char *_data;
     size_t _size;
     size_t _pos;
+    bool _mapped;
+    ptr<Archive> _archive;
 };
 
 GV_NS_END
@@ -0,0 +1,220 @@
+#include "opengxv.h"
+#include "gv_glrenderer.h"
+#include "gv_log.h"
+
+GV_NS_BEGIN
+
+enum {
+    ATTRIB_POSITION,
+    ATTRIB_TEXCOORD,
+    ATTRIB_COLOR,
+};
+
+static const char *__vertexShader =
+    "uniform mat4 u_projection;\n"
+    "attribute vec3 a_position;\n"
+    "attribute vec2 a_texCoord;\n"
+    "attribute vec4 a_color;\n"
+    "varying vec2 v_texCoord;\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "    gl_Position = u_projection * vec4(a_position, 1.0);\n"
+    "    v_texCoord = a_texCoord;\n"
+    "    v_color = a_color;\n"
+    "}\n";
+
+static const char *__fragmentShader =
+    "uniform sampler2D u_texture;\n"
+    "varying vec2 v_texCoord;\n"
+    "varying vec4 v_color;\n"
+    "void main() {\n"
+    "    gl_FragColor = v_color * texture2D(u_texture, v_texCoord);\n"
+    "}\n";
+
+static GLuint compileShader(GLenum type, const char *source) noexcept {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint status;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        char log[1024];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        gv_error("gl compile shader failed, %s.", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+GLRenderer::GLRenderer() noexcept
+: _program(),
+  _projectionLocation(-1),
+  _buffer(),
+  _white(),
+  _texture(),
+  _blend(BlendMode::NORMAL),
+  _pmAlpha(false),
+  _ready(false)
+{ }
+
+GLRenderer::~GLRenderer() noexcept {
+    if (_ready) {
+        glDeleteProgram(_program);
+        glDeleteBuffers(1, &_buffer);
+        glDeleteTextures(1, &_white);
+    }
+}
+
+bool GLRenderer::setup() noexcept {
+    GLuint vs = compileShader(GL_VERTEX_SHADER, __vertexShader);
+    GLuint fs = compileShader(GL_FRAGMENT_SHADER, __fragmentShader);
+    if (!vs || !fs) {
+        return false;
+    }
+
+    _program = glCreateProgram();
+    glAttachShader(_program, vs);
+    glAttachShader(_program, fs);
+    glBindAttribLocation(_program, ATTRIB_POSITION, "a_position");
+    glBindAttribLocation(_program, ATTRIB_TEXCOORD, "a_texCoord");
+    glBindAttribLocation(_program, ATTRIB_COLOR, "a_color");
+    glLinkProgram(_program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint status;
+    glGetProgramiv(_program, GL_LINK_STATUS, &status);
+    if (!status) {
+        char log[1024];
+        glGetProgramInfoLog(_program, sizeof(log), nullptr, log);
+        gv_error("gl link program failed, %s.", log);
+        glDeleteProgram(_program);
+        return false;
+    }
+    _projectionLocation = glGetUniformLocation(_program, "u_projection");
+    glUseProgram(_program);
+    glUniform1i(glGetUniformLocation(_program, "u_texture"), 0);
+
+    glGenBuffers(1, &_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, _buffer);
+    glVertexAttribPointer(ATTRIB_POSITION, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, x));
+    glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, u));
+    glVertexAttribPointer(ATTRIB_COLOR, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (const GLvoid*)offsetof(Vertex, r));
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+
+    static const unsigned char white[4] = { 0xff, 0xff, 0xff, 0xff };
+    glGenTextures(1, &_white);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    _texture = _white;
+
+    // the untextured batches are premultiplied
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    _blend = BlendMode::NORMAL;
+    _pmAlpha = true;
+    return true;
+}
+
+void GLRenderer::viewport(unsigned width, unsigned height) noexcept {
+    Renderer::viewport(width, height);
+    glViewport(0, 0, (GLsizei)width, (GLsizei)height);
+}
+
+void GLRenderer::clear(unsigned color) noexcept {
+    if (!_ready && !(_ready = setup())) {
+        return;
+    }
+    glClearColor(
+        ((color >> 16) & 0xff) / 255.f,
+        ((color >> 8) & 0xff) / 255.f,
+        (color & 0xff) / 255.f,
+        ((color >> 24) & 0xff) / 255.f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+/* the premultiplied colors are already scaled by their alpha, which
+ * only NORMAL and ADD apply to the source */
+void GLRenderer::blend(BlendMode mode, bool pmAlpha) noexcept {
+    if (mode == _blend && pmAlpha == _pmAlpha) {
+        return;
+    }
+    _blend = mode;
+    _pmAlpha = pmAlpha;
+    switch (mode) {
+    case BlendMode::ADD:
+        glBlendFunc(pmAlpha ? GL_ONE : GL_SRC_ALPHA, GL_ONE);
+        break;
+    case BlendMode::MULTIPLY:
+        glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    case BlendMode::SCREEN:
+        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_COLOR);
+        break;
+    default:
+        glBlendFunc(pmAlpha ? GL_ONE : GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        break;
+    }
+}
+
+void GLRenderer::draw(const Vertex *vertices, unsigned count, const Batch *batches, unsigned batchCount) noexcept {
+    if (!_ready) {
+        return;
+    }
+    glUniformMatrix4fv(_projectionLocation, 1, GL_FALSE, _projection->data());
+
+    // orphan the previous storage so the driver doesn't stall on it
+    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * count, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(Vertex) * count, vertices);
+
+    // textures may have been bound behind our back by Texture::create()
+    _texture = 0;
+
+    for (const Batch *end = batches + batchCount; batches < end; ++batches) {
+        GLuint texture = batches->texture ? batches->texture->id() : _white;
+        if (texture != _texture) {
+            glBindTexture(GL_TEXTURE_2D, texture);
+            _texture = texture;
+        }
+        blend(batches->blend, batches->pmAlpha());
+        glDrawArrays(GL_TRIANGLES, (GLint)batches->first, (GLsizei)batches->count);
+    }
+}
+
+void GLRenderer::present() noexcept {
+    glFlush();
+}
+
+ptr<Chunk> GLRenderer::readPixels() noexcept {
+    if (!_width || !_height) {
+        return nullptr;
+    }
+    size_t rowbytes = _width * 4;
+    object<Chunk> pixels(rowbytes * _height);
+    if (!pixels->data()) {
+        return nullptr;
+    }
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, (GLsizei)_width, (GLsizei)_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+
+    // gl rows are bottom up
+    object<Chunk> tmp(rowbytes);
+    unsigned char *top = pixels->data();
+    unsigned char *bottom = top + rowbytes * (_height - 1);
+    for (; top < bottom; top += rowbytes, bottom -= rowbytes) {
+        memcpy(tmp->data(), top, rowbytes);
+        memcpy(top, bottom, rowbytes);
+        memcpy(bottom, tmp->data(), rowbytes);
+    }
+    return pixels;
+}
+
+GV_NS_END
+
@@ -0,0 +1,47 @@
+#ifndef __GV_GL_RENDERER_H__
+#define __GV_GL_RENDERER_H__
+
+#include "gv_renderer.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief The GL backend. The whole vertex stream of a flush is 
+ *        uploaded into one streaming vertex buffer and every batch
+ *        is a single glDrawArrays() with one shader program;
+ *        untextured batches sample a 1x1 white texture. The blend
+ *        function follows the mode and whether the batch is
+ *        premultiplied, it's only set when one of them changes.
+ */
+class GLRenderer : public Renderer {
+    friend class Object;
+public:
+    virtual void viewport(unsigned width, unsigned height) noexcept override;
+    virtual ptr<Chunk> readPixels() noexcept override;
+
+protected:
+    GLRenderer() noexcept;
+    ~GLRenderer() noexcept;
+
+    virtual void clear(unsigned color) noexcept override;
+    virtual void draw(const Vertex *vertices, unsigned count, const Batch *batches, unsigned batchCount) noexcept override;
+    virtual void present() noexcept override;
+
+private:
+    bool setup() noexcept;
+    void blend(BlendMode mode, bool pmAlpha) noexcept;
+
+    GLuint    _program;
+    GLint     _projectionLocation;
+    GLuint    _buffer;
+    GLuint    _white;
+    GLuint    _texture;
+    BlendMode _blend;
+    bool      _pmAlpha;
+    bool      _ready;
+};
+
+GV_NS_END
+
+#endif
+
@@ -1,6 +1,7 @@
 #ifndef __GV_HASHMAP_H__
 #define __GV_HASHMAP_H__
 
+#include <cstring>
 #include "gv_platform.h"
 #include "gv_hash.h"
 #include "gv_object.h"
@@ -55,7 +56,7 @@ private:
     }
     type *get_next(unsigned bucket, type *elm) noexcept {
         type* next = list_type::next(elm);
-        if (next && get_bucket(get_entry(elm)._hash) != bucket) {
+        if (next && get_bucket(get_entry(next)._hash) != bucket) {
             next = nullptr;
         }
         return next;
@@ -134,7 +135,9 @@ public:
         }
 
         ++_size;
-        return std::pair<pointer, bool>(link(head, constructor(std::forward<_Args>(args)...)), true);
+        pointer new_elm = constructor(std::forward<_Args>(args)...);
+        get_entry(new_elm)._hash = hash;
+        return std::pair<pointer, bool>(link(head, new_elm), true);
     }
 
     type* find(const key_type &key) noexcept {
@@ -191,6 +194,7 @@ public:
         }
 
         ++_size;
+        get_entry(new_elm)._hash = hash;
         link(head, new_elm);
         return ret;
     }
@@ -12,7 +12,7 @@ Image::Image() noexcept
   _height()
 {}
 
-ptr<Image> Image::load(const ptr<Path> &path, FileType type) noexcept {
+ptr<Image> Image::load(const ptr<Path> &path, FileType type, PixelFormat format, PixelDither dither, bool premultiply) noexcept {
     if (FileType::UNKNOWN == type) {
         type = File::type(path);
         if (FileType::UNKNOWN == type) {
@@ -24,16 +24,32 @@ ptr<Image> Image::load(const ptr<Path> &path, FileType type) noexcept {
     if (!file) {
         return nullptr;
     }
+    return decode(file, type, format, dither, premultiply);
+}
 
-    ptr<Image> image;
+ptr<Image> Image::decode(File *file, FileType type, PixelFormat format, PixelDither dither, bool premultiply) noexcept {
     switch (type) {
     case FileType::PNG:
-        image = PngCodec::load(file);
-        break;
+        return PngCodec::load(file, format, dither, premultiply);
     default:
         return nullptr;
     }
-    return image;
+}
+
+bool Image::convert(PixelFormat format, PixelDither dither) noexcept {
+    if (format == _pixelInfo->format()) {
+        return true;
+    }
+    if (_pixelInfo->compressed() || _mipmaps.size() != 1) {
+        return false;
+    }
+    ptr<Chunk> chunk = _pixelInfo->convert(*_mipmaps[0], _width, _height, format, dither);
+    if (!chunk) {
+        return false;
+    }
+    _mipmaps[0] = chunk;
+    _pixelInfo = PixelInfo::get(format);
+    return true;
 }
 
 GV_NS_END
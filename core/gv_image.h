@@ -7,6 +7,7 @@
 #include "gv_path.h"
 #include "gv_file.h"
 #include "gv_pixel.h"
+#include "gv_chunk.h"
 
 GV_NS_BEGIN
 
@@ -14,7 +15,20 @@ class Image : public Object {
     friend class Object;
     friend class PngCodec;
 public:
-    static ptr<Image> load(const ptr<Path> &path, FileType type = FileType::UNKNOWN) noexcept;
+    /**
+     * @brief Loads and decodes path. A known format is the one the
+     *        decoder converts the pixels to as it goes, with dither, the
+     *        image keeps its own format if the decoder can't produce it.
+     *        With premultiply the colors come multiplied by their alpha,
+     *        see pmAlpha().
+     */
+    static ptr<Image> load(const ptr<Path> &path, FileType type = FileType::UNKNOWN, PixelFormat format = PixelFormat::UNKNOWN,
+                           PixelDither dither = PixelDither::NONE, bool premultiply = false) noexcept;
+    /**
+     * @brief Decodes file, type must be known. Safe off the main thread.
+     */
+    static ptr<Image> decode(File *file, FileType type, PixelFormat format = PixelFormat::UNKNOWN,
+                             PixelDither dither = PixelDither::NONE, bool premultiply = false) noexcept;
 
     unsigned width() const noexcept {
         return _width;
@@ -22,22 +36,32 @@ public:
     unsigned height() const noexcept {
         return _height;
     }
+    /**
+     * @brief Whether the colors are premultiplied by alpha, which the
+     *        opaque images are as well.
+     */
     bool pmAlpha() const noexcept {
         return _pmAlpha;
     }
     const ptr<PixelInfo> &pixelInfo() const noexcept {
         return _pixelInfo;
     }
-    std::vector<Chunk> &mipmaps() noexcept {
+    std::vector<ptr<Chunk>> &mipmaps() noexcept {
         return _mipmaps;
     }
+    /**
+     * @brief Converts the pixels to format, with dither. Only an
+     *        uncompressed image of one level converts, false if it
+     *        can't. Safe off the main thread.
+     */
+    bool convert(PixelFormat format, PixelDither dither) noexcept;
 protected:
     Image() noexcept;
     ptr<PixelInfo> _pixelInfo;
     bool _pmAlpha;
     unsigned _width;
     unsigned _height;
-    std::vector<Chunk> _mipmaps;
+    std::vector<ptr<Chunk>> _mipmaps;
 };
 
 GV_NS_END
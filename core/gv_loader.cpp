@@ -0,0 +1,219 @@
+#include "opengxv.h"
+#include <algorithm>
+#include "gv_loader.h"
+#include "gv_texturecache.h"
+
+GV_NS_BEGIN
+
+enum {
+    MAX_THREADS = 4,
+};
+
+/* LoadRequest */
+LoadRequest::LoadRequest(const ptr<Path> &path, FileType type, PixelFormat format, bool texture, int priority) noexcept
+: _source(path),
+  _path(path->tostring()),
+  _type(type),
+  _format(texture ? Env::instance()->pixelFormat(format) : format),
+  _dither(Env::instance()->pixelDither),
+  _errorBound(Env::instance()->pixelErrorBound),
+  _premultiply(texture && Env::instance()->premultiplyAlpha),
+  _wantTexture(texture),
+  _priority(priority),
+  _serial(),
+  _state(LoadState::QUEUED),
+  _canceled(false)
+{ }
+
+void LoadRequest::cancel() noexcept {
+    _canceled.store(true, std::memory_order_relaxed);
+    LoadState queued = LoadState::QUEUED;
+    _state.compare_exchange_strong(queued, LoadState::CANCELED, std::memory_order_acq_rel);
+}
+
+bool LoadRequest::claim() noexcept {
+    LoadState queued = LoadState::QUEUED;
+    return _state.compare_exchange_strong(queued, LoadState::LOADING, std::memory_order_acq_rel);
+}
+
+/* runs on the thread which claimed the request, the image is only
+ * reached by the main thread once the state is DECODED */
+void LoadRequest::decode() noexcept {
+    if (!_canceled.load(std::memory_order_relaxed)) {
+        ptr<File> file = File::load(_path);
+        if (file) {
+            _image = Image::decode(file, _type, _wantTexture ? _format : PixelFormat::UNKNOWN, _dither, _premultiply);
+        }
+        if (!_image) {
+            gv_error("can't load image '%s'.", _path.c_str());
+        }
+        else if (_wantTexture) {
+            convert();
+        }
+    }
+    _state.store(LoadState::DECODED, std::memory_order_release);
+}
+
+/* picks the texture format and converts to it here, so that the main
+ * thread only uploads. An image which can't convert keeps its format
+ * and Texture::create() reports it */
+void LoadRequest::convert() noexcept {
+    const ptr<PixelInfo> &info = _image->pixelInfo();
+    if (info->compressed() || _image->mipmaps().size() != 1) {
+        return;
+    }
+    PixelFormat format = _format;
+    if (format == PixelFormat::UNKNOWN) {
+        format = info->smallest(_image->mipmaps()[0]->data(), (size_t)_image->width() * _image->height(), _errorBound);
+    }
+    if (PixelInfo::get(format)->support()) {
+        _image->convert(format, _dither);
+    }
+}
+
+/* Loader */
+Loader::Loader() noexcept
+: _serial(),
+  _exit(false)
+{ }
+
+Loader::~Loader() noexcept {
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _exit = true;
+    }
+    _ready.notify_all();
+    for (auto &thread : _threads) {
+        thread.join();
+    }
+}
+
+ptr<LoadRequest> Loader::start(const ptr<Path> &path, PixelFormat format, bool texture, int priority, std::nullptr_t) noexcept {
+    FileType type = File::type(path);
+    if (type < FileType::IMAGE_BEGIN || type >= FileType::IMAGE_END) {
+        return nullptr;
+    }
+    ptr<LoadRequest> request = object<LoadRequest>(path, type, format, texture, priority);
+    push(request);
+    return request;
+}
+
+void Loader::push(const ptr<LoadRequest> &request) noexcept {
+    // a cached texture completes at the next update
+    if (request->_wantTexture) {
+        request->_texture = TextureCache::instance()->find(request->_source, request->_format);
+        if (request->_texture) {
+            request->_state.store(LoadState::DECODED, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(_lock);
+            _finished.emplace_back(request);
+            return;
+        }
+    }
+
+    if (_threads.empty()) {
+        unsigned count = std::thread::hardware_concurrency();
+        count = count > 1 ? std::min(count - 1, (unsigned)MAX_THREADS) : 1;
+        for (unsigned i = 0; i < count; ++i) {
+            _threads.emplace_back(&Loader::run, this);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        request->_serial = _serial++;
+        _queue.emplace_back(request);
+        std::push_heap(_queue.begin(), _queue.end(), compare());
+    }
+    _ready.notify_one();
+}
+
+void Loader::run() noexcept {
+    std::unique_lock<std::mutex> lock(_lock);
+    for (;;) {
+        _ready.wait(lock, [this]() {
+            return _exit || !_queue.empty();
+        });
+        if (_exit) {
+            break;
+        }
+        std::pop_heap(_queue.begin(), _queue.end(), compare());
+        ptr<LoadRequest> request = std::move(_queue.back());
+        _queue.pop_back();
+
+        if (request->claim()) {
+            lock.unlock();
+            request->decode();
+            lock.lock();
+            _decoded.notify_all();
+        }
+
+        // always handed back, the last reference must be dropped on
+        // the main thread which owns what the request refers to
+        _finished.emplace_back(std::move(request));
+    }
+    lock.unlock();
+    mem_flush();
+}
+
+void Loader::finish(LoadRequest *request) noexcept {
+    if (request->state() != LoadState::DECODED) {
+        return;
+    }
+    if (request->_canceled.load(std::memory_order_relaxed)) {
+        request->_image = nullptr;
+        request->_texture = nullptr;
+        request->_state.store(LoadState::CANCELED, std::memory_order_relaxed);
+        return;
+    }
+    bool loaded;
+    if (request->_wantTexture) {
+        if (request->_image) {
+            // converted by the worker, uploaded as it is
+            request->_texture = Texture::create(request->_image.get(), request->_image->pixelInfo()->format());
+            request->_image = nullptr;
+            if (request->_texture) {
+                TextureCache::instance()->put(request->_source, request->_format, request->_texture);
+            }
+        }
+        loaded = request->_texture != nullptr;
+    }
+    else {
+        loaded = request->_image != nullptr;
+    }
+    request->_state.store(loaded ? LoadState::LOADED : LoadState::FAILED, std::memory_order_relaxed);
+    request->complete();
+}
+
+void Loader::wait(LoadRequest *request) noexcept {
+    if (request->claim()) {
+        request->decode();
+    }
+    else {
+        std::unique_lock<std::mutex> lock(_lock);
+        _decoded.wait(lock, [request]() {
+            return request->state() != LoadState::LOADING;
+        });
+    }
+    finish(request);
+}
+
+void Loader::update() noexcept {
+    // no thread, no one else touches the queues
+    if (_threads.empty() && _finished.empty()) {
+        return;
+    }
+    std::vector<ptr<LoadRequest>> finished;
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        if (_finished.empty()) {
+            return;
+        }
+        finished.swap(_finished);
+    }
+    for (auto &request : finished) {
+        finish(request);
+    }
+}
+
+GV_NS_END
+
@@ -0,0 +1,192 @@
+#ifndef __GV_LOADER_H__
+#define __GV_LOADER_H__
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "gv_object.h"
+#include "gv_singleton.h"
+#include "gv_log.h"
+#include "gv_image.h"
+#include "gv_texture.h"
+
+GV_NS_BEGIN
+
+enum class LoadState {
+    QUEUED,
+    LOADING,
+    DECODED,
+    LOADED,
+    FAILED,
+    CANCELED,
+};
+
+/**
+ * @brief An asynchronous load started by the Loader. The file is read
+ *        and decoded on a loader thread, the result is published and
+ *        the completion called on the main thread.
+ */
+class LoadRequest : public SharedObject {
+    friend class Object;
+    friend class Loader;
+public:
+    LoadState state() const noexcept {
+        return _state.load(std::memory_order_acquire);
+    }
+    bool done() const noexcept {
+        return state() > LoadState::DECODED;
+    }
+    int priority() const noexcept {
+        return _priority;
+    }
+    /**
+     * @brief The decoded image once LOADED, texture loads keep only 
+     *        the texture.
+     */
+    const ptr<Image> &image() const noexcept {
+        return _image;
+    }
+    const ptr<Texture> &texture() const noexcept {
+        return _texture;
+    }
+    /**
+     * @brief Drops the request, its completion won't be called. From
+     *        the main thread.
+     */
+    void cancel() noexcept;
+
+protected:
+    LoadRequest(const ptr<Path> &path, FileType type, PixelFormat format, bool texture, int priority) noexcept;
+
+    /**
+     * @brief Called on the main thread once the request is LOADED or
+     *        FAILED.
+     */
+    virtual void complete() noexcept {}
+
+private:
+    bool claim() noexcept;
+    void decode() noexcept;
+    void convert() noexcept;
+
+    ptr<Path>              _source;
+    std::string            _path;
+    FileType               _type;
+    PixelFormat            _format;
+    PixelDither            _dither;
+    unsigned               _errorBound;
+    bool                   _premultiply;
+    bool                   _wantTexture;
+    int                    _priority;
+    unsigned               _serial;
+    std::atomic<LoadState> _state;
+    std::atomic<bool>      _canceled;
+    ptr<Image>             _image;
+    ptr<Texture>           _texture;
+};
+
+/**
+ * @brief Reads and decodes assets on a pool of worker threads. The
+ *        threads are started by the first load, the Stage publishes
+ *        the finished loads at the start of each frame.
+ */
+class Loader : public Object, public singleton<Loader, Log> {
+    friend class Object;
+
+    template <typename _Functor>
+    struct FunctorRequest : LoadRequest {
+        _Functor _functor;
+        void complete() noexcept override {
+            _functor(this);
+        }
+        template <typename _F>
+        FunctorRequest(const ptr<Path> &path, FileType type, PixelFormat format, bool texture, int priority, _F &&functor) noexcept :
+            LoadRequest(path, type, format, texture, priority),
+            _functor(std::forward<_F>(functor)) { }
+    };
+public:
+    ~Loader() noexcept;
+
+    /**
+     * @brief Loads an image, higher priorities are decoded first.
+     *        Returns nullptr if the file type isn't an image one.
+     */
+    ptr<LoadRequest> loadImage(const ptr<Path> &path, int priority = 0) noexcept {
+        return start(path, PixelFormat::UNKNOWN, false, priority, nullptr);
+    }
+    template <typename _Functor>
+    ptr<LoadRequest> loadImage(const ptr<Path> &path, _Functor &&functor, int priority = 0) noexcept {
+        return start(path, PixelFormat::UNKNOWN, false, priority, std::forward<_Functor>(functor));
+    }
+
+    /**
+     * @brief Loads an image and makes a texture of it on the main
+     *        thread, see Texture::create(). The textures are shared
+     *        through the TextureCache.
+     */
+    ptr<LoadRequest> loadTexture(const ptr<Path> &path, PixelFormat format = PixelFormat::UNKNOWN, int priority = 0) noexcept {
+        return start(path, format, true, priority, nullptr);
+    }
+    template <typename _Functor>
+    ptr<LoadRequest> loadTexture(const ptr<Path> &path, _Functor &&functor, PixelFormat format = PixelFormat::UNKNOWN, int priority = 0) noexcept {
+        return start(path, format, true, priority, std::forward<_Functor>(functor));
+    }
+
+    /**
+     * @brief Blocks until request is done, decoding it on the calling
+     *        thread if no worker has picked it yet. From the main
+     *        thread.
+     */
+    void wait(LoadRequest *request) noexcept;
+
+    /**
+     * @brief Publishes the finished loads and calls their completion.
+     *        From the main thread.
+     */
+    void update() noexcept;
+
+private:
+    Loader() noexcept;
+
+    template <typename _Functor>
+    ptr<LoadRequest> start(const ptr<Path> &path, PixelFormat format, bool texture, int priority, _Functor &&functor) noexcept {
+        FileType type = File::type(path);
+        if (type < FileType::IMAGE_BEGIN || type >= FileType::IMAGE_END) {
+            return nullptr;
+        }
+        ptr<LoadRequest> request = object<FunctorRequest<typename std::decay<_Functor>::type>>(
+            path, type, format, texture, priority, std::forward<_Functor>(functor));
+        push(request);
+        return request;
+    }
+    ptr<LoadRequest> start(const ptr<Path> &path, PixelFormat format, bool texture, int priority, std::nullptr_t) noexcept;
+    void push(const ptr<LoadRequest> &request) noexcept;
+    void run() noexcept;
+    void finish(LoadRequest *request) noexcept;
+
+    struct compare {
+        bool operator()(const ptr<LoadRequest> &lhs, const ptr<LoadRequest> &rhs) const noexcept {
+            if (lhs->_priority != rhs->_priority) {
+                return lhs->_priority < rhs->_priority;
+            }
+            return lhs->_serial > rhs->_serial;
+        }
+    };
+
+    std::mutex                    _lock;
+    std::condition_variable       _ready;
+    std::condition_variable       _decoded;
+    std::vector<ptr<LoadRequest>> _queue;
+    std::vector<ptr<LoadRequest>> _finished;
+    std::vector<std::thread>      _threads;
+    unsigned                      _serial;
+    bool                          _exit;
+};
+
+GV_NS_END
+
+#endif
+
@@ -9,6 +9,7 @@ GV_NS_BEGIN
 Log::Log() : _chunk(8192), _pos() {}
 
 void Log::begin(LogLevel level) noexcept {
+    _lock.lock();
     _level = level;
     _pos = 0;
 }
@@ -20,6 +21,7 @@ void Log::end() noexcept {
         fputs((char*)_chunk->data(), stderr);
         fflush(stderr);
     }
+    _lock.unlock();
 }
 
 void Log::vprint(const char *fmt, va_list ap) noexcept {
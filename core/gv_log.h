@@ -2,6 +2,7 @@
 #define __GV_LOG_H__
 
 #include <cstdarg>
+#include <mutex>
 
 #include "gv_chunk.h"
 #include "gv_singleton.h"
@@ -18,6 +19,9 @@ enum class LogLevel {
 class Log : public Object, public singleton<Log> {
     friend class Object;
 public:
+    /**
+     * @brief Starts a line, the other threads wait until end().
+     */
     void begin(LogLevel level) noexcept;
     void end() noexcept;
     void vprint(const char *fmt, va_list ap) noexcept;
@@ -37,6 +41,7 @@ private:
     object<Chunk> _chunk;
     size_t        _pos;
     LogLevel      _level;
+    std::mutex    _lock;
 }; 
 
 GV_NS_END
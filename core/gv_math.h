@@ -5,6 +5,11 @@
 #include "gv_log.h"
 #include "Eigen/Eigen"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GV_SSE 1
+#include <xmmintrin.h>
+#endif
+
 GV_NS_BEGIN
 
 typedef Eigen::Vector2f     Vec2f;
@@ -99,6 +104,9 @@ struct Box2f final {
     bool contains(const Box2f &x) const noexcept {
         return (min.array() <= x.min.array()).all() && (x.max.array() <= max.array()).all();
     }
+    bool intersects(const Box2f &x) const noexcept {
+        return (min.array() <= x.max.array()).all() && (x.min.array() <= max.array()).all();
+    }
     bool inside(const Box2f &x) const noexcept {
         return (min.array() > x.min.array()).all() && (x.max.array() > max.array()).all();
     }
@@ -163,7 +171,7 @@ struct Box2f final {
         return Box2f(min - x, max - x);
     }
     bool empty() const noexcept {
-        return (min.array() <= max.array()).any();
+        return (min.array() >= max.array()).any();
     }
     bool operator==(const Box2f &rhs) const noexcept {
         if (empty() && rhs.empty()){
@@ -179,11 +187,145 @@ struct Box2f final {
     }
 };
 
+/**
+ * @brief A 2x3 affine transform, the compact form of a Matrix that
+ *        keeps the z = 0 plane in place (no z translation, no x/y
+ *        rotation).
+ *
+ * Stored as the 2x2 linear part column by column followed by the
+ * translation: a b c d tx ty, then the z scale which only matters
+ * when expanded back to a Matrix.
+ */
+struct Matrix2D final {
+    float m[7];
+
+    Matrix2D() noexcept {}
+    explicit Matrix2D(const Matrix &mat) noexcept {
+        m[0] = mat(0, 0);
+        m[1] = mat(1, 0);
+        m[2] = mat(0, 1);
+        m[3] = mat(1, 1);
+        m[4] = mat(0, 3);
+        m[5] = mat(1, 3);
+        m[6] = mat(2, 2);
+    }
+
+    /* rotations about z leave rounding noise in the z row and column */
+    static bool flat(const Matrix &mat) noexcept {
+        const float e = 1e-6f;
+        return std::abs(mat(2, 0)) < e && std::abs(mat(2, 1)) < e && 
+            std::abs(mat(0, 2)) < e && std::abs(mat(1, 2)) < e && mat(2, 3) == 0.f;
+    }
+    void setIdentity() noexcept {
+        m[0] = 1.f;
+        m[1] = 0.f;
+        m[2] = 0.f;
+        m[3] = 1.f;
+        m[4] = 0.f;
+        m[5] = 0.f;
+        m[6] = 1.f;
+    }
+    void expand(Matrix &mat) const noexcept {
+        mat.matrix() << 
+            m[0], m[2], 0.f, m[4],
+            m[1], m[3], 0.f, m[5],
+            0.f,  0.f,  m[6], 0.f,
+            0.f,  0.f,  0.f, 1.f;
+    }
+
+    Matrix2D inverse() const noexcept {
+        Matrix2D ret;
+        float det = m[0] * m[3] - m[2] * m[1];
+        float inv = det != 0.f ? 1.f / det : 0.f;
+        ret.m[0] = m[3] * inv;
+        ret.m[1] = -m[1] * inv;
+        ret.m[2] = -m[2] * inv;
+        ret.m[3] = m[0] * inv;
+        ret.m[4] = -(ret.m[0] * m[4] + ret.m[2] * m[5]);
+        ret.m[5] = -(ret.m[1] * m[4] + ret.m[3] * m[5]);
+        ret.m[6] = m[6] != 0.f ? 1.f / m[6] : 0.f;
+        return ret;
+    }
+
+    Matrix2D operator*(const Matrix2D &rhs) const noexcept {
+        Matrix2D ret;
+#if GV_SSE
+        __m128 l = _mm_loadu_ps(m);
+        __m128 lo = _mm_movelh_ps(l, l);                            // a b a b
+        __m128 hi = _mm_movehl_ps(l, l);                            // c d c d
+        __m128 r = _mm_loadu_ps(rhs.m);
+        __m128 rx = _mm_shuffle_ps(r, r, _MM_SHUFFLE(2, 2, 0, 0));  // ra ra rc rc
+        __m128 ry = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 1, 1));  // rb rb rd rd
+        _mm_storeu_ps(ret.m, _mm_add_ps(_mm_mul_ps(lo, rx), _mm_mul_ps(hi, ry)));
+
+        __m128 t = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(m + 4));
+        __m128 rt = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(rhs.m + 4));
+        t = _mm_add_ps(_mm_add_ps(
+            _mm_mul_ps(lo, _mm_shuffle_ps(rt, rt, _MM_SHUFFLE(0, 0, 0, 0))), 
+            _mm_mul_ps(hi, _mm_shuffle_ps(rt, rt, _MM_SHUFFLE(1, 1, 1, 1)))), t);
+        _mm_storel_pi((__m64*)(ret.m + 4), t);
+        ret.m[6] = m[6] * rhs.m[6];
+#else
+        ret.m[0] = m[0] * rhs.m[0] + m[2] * rhs.m[1];
+        ret.m[1] = m[1] * rhs.m[0] + m[3] * rhs.m[1];
+        ret.m[2] = m[0] * rhs.m[2] + m[2] * rhs.m[3];
+        ret.m[3] = m[1] * rhs.m[2] + m[3] * rhs.m[3];
+        ret.m[4] = m[0] * rhs.m[4] + m[2] * rhs.m[5] + m[4];
+        ret.m[5] = m[1] * rhs.m[4] + m[3] * rhs.m[5] + m[5];
+        ret.m[6] = m[6] * rhs.m[6];
+#endif
+        return ret;
+    }
+
+    Vec2f operator*(const Vec2f &rhs) const noexcept {
+        return Vec2f(
+            m[0] * rhs.x() + m[2] * rhs.y() + m[4], 
+            m[1] * rhs.x() + m[3] * rhs.y() + m[5]);
+    }
+
+    /**
+     * @brief Bounding box of the four transformed corners of rhs.
+     */
+    Box2f operator*(const Box2f &rhs) const noexcept {
+#if GV_SSE
+        __m128 xs = _mm_setr_ps(rhs.min.x(), rhs.max.x(), rhs.min.x(), rhs.max.x());
+        __m128 ys = _mm_setr_ps(rhs.min.y(), rhs.min.y(), rhs.max.y(), rhs.max.y());
+        __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[0]), xs), _mm_mul_ps(_mm_set1_ps(m[2]), ys)), _mm_set1_ps(m[4]));
+        __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m[1]), xs), _mm_mul_ps(_mm_set1_ps(m[3]), ys)), _mm_set1_ps(m[5]));
+
+        // x0 x1 y0 y1 / x2 x3 y2 y3, then fold the lanes pairwise
+        __m128 lo = _mm_movelh_ps(x, y);
+        __m128 hi = _mm_movehl_ps(y, x);
+        __m128 mn = _mm_min_ps(lo, hi);
+        __m128 mx = _mm_max_ps(lo, hi);
+        mn = _mm_min_ps(mn, _mm_shuffle_ps(mn, mn, _MM_SHUFFLE(2, 3, 0, 1)));
+        mx = _mm_max_ps(mx, _mm_shuffle_ps(mx, mx, _MM_SHUFFLE(2, 3, 0, 1)));
+        float v[8];
+        _mm_storeu_ps(v, mn);
+        _mm_storeu_ps(v + 4, mx);
+        return Box2f(Vec2f(v[0], v[2]), Vec2f(v[4], v[6]));
+#else
+        Vec2f p0 = (*this) * rhs.min;
+        Vec2f p1 = (*this) * Vec2f(rhs.max.x(), rhs.min.y());
+        Vec2f p2 = (*this) * Vec2f(rhs.min.x(), rhs.max.y());
+        Vec2f p3 = (*this) * rhs.max;
+        return Box2f(
+            p0.cwiseMin(p1).cwiseMin(p2).cwiseMin(p3),
+            p0.cwiseMax(p1).cwiseMax(p2).cwiseMax(p3));
+#endif
+    }
+};
+
 inline Box2f operator*(const Matrix &lhs, const Box2f &rhs) noexcept {
-    Vec3f min(rhs.min.x(), rhs.min.y(), 0.0f);
-    Vec3f max(rhs.max.x(), rhs.max.y(), 0.0f);
-    min = lhs * min;
-    max = lhs * max;
+    if (Matrix2D::flat(lhs)) {
+        return Matrix2D(lhs) * rhs;
+    }
+    Vec3f p0 = lhs * Vec3f(rhs.min.x(), rhs.min.y(), 0.f);
+    Vec3f p1 = lhs * Vec3f(rhs.max.x(), rhs.min.y(), 0.f);
+    Vec3f p2 = lhs * Vec3f(rhs.min.x(), rhs.max.y(), 0.f);
+    Vec3f p3 = lhs * Vec3f(rhs.max.x(), rhs.max.y(), 0.f);
+    Vec3f min = p0.cwiseMin(p1).cwiseMin(p2).cwiseMin(p3);
+    Vec3f max = p0.cwiseMax(p1).cwiseMax(p2).cwiseMax(p3);
     return Box2f(Vec2f(min.x(), min.y()), Vec2f(max.x(), max.y()));
 }
 
@@ -191,11 +333,11 @@ GV_MATH_BEGIN
 
 void ortho(float left, float right, float top, float bottom, float n, float f, Matrix &mat) noexcept;
 
-inline void matrixLinear(Matrix *mat, Matrix3f *rot, Matrix3f *scale) noexcept {
+inline void matrixLinear(const Matrix *mat, Matrix3f *rot, Matrix3f *scale) noexcept {
     mat->computeRotationScaling(rot, scale);
 }
 
-inline void matrixLinear(Matrix *mat, Vec3f *rot, Matrix3f *scale) noexcept {
+inline void matrixLinear(const Matrix *mat, Vec3f *rot, Matrix3f *scale) noexcept {
     Matrix3f m;
     matrixLinear(mat, &m, scale);
     *rot = m.eulerAngles(0, 1, 2);
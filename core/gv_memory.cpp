@@ -0,0 +1,133 @@
+#include "opengxv.h"
+#include <cstdlib>
+#include <mutex>
+#include "gv_memory.h"
+
+GV_NS_BEGIN
+
+namespace {
+
+enum {
+    GRANULE     = 16,
+    MAX_SMALL   = 1024,
+    CLASSES     = MAX_SMALL / GRANULE,
+    BATCH       = 32,
+    SLAB_SIZE   = 64 * 1024,
+};
+
+struct FreeBlock {
+    FreeBlock *next;
+};
+
+/* plain data, so that it stays usable while statics are destroyed */
+struct ThreadCache {
+    FreeBlock *lists[CLASSES];
+    unsigned   counts[CLASSES];
+};
+
+}
+
+static GV_THREAD_LOCAL ThreadCache __cache;
+
+/* the shared pool, the slabs are never given back to the system */
+static std::mutex __depotLock;
+static FreeBlock *__depot[CLASSES];
+static char      *__slab;
+static char      *__slabEnd;
+
+static inline unsigned size_class(size_t size) noexcept {
+    return size ? (unsigned)((size - 1) / GRANULE) : 0;
+}
+
+/* moves up to BATCH blocks of cls to the thread cache, carving a new
+ * slab when the depot is empty */
+static FreeBlock *refill(unsigned cls) noexcept {
+    size_t size = (cls + 1) * GRANULE;
+    FreeBlock *list = nullptr;
+    unsigned count = 0;
+
+    std::lock_guard<std::mutex> lock(__depotLock);
+    while (count < BATCH && __depot[cls]) {
+        FreeBlock *block = __depot[cls];
+        __depot[cls] = block->next;
+        block->next = list;
+        list = block;
+        ++count;
+    }
+    while (count < BATCH) {
+        if (__slab + size > __slabEnd) {
+            char *slab = (char*)std::malloc(SLAB_SIZE + GRANULE);
+            if (!slab) {
+                break;
+            }
+            __slab = (char*)(((uintptr_t)slab + GRANULE - 1) & ~(uintptr_t)(GRANULE - 1));
+            __slabEnd = slab + SLAB_SIZE + GRANULE;
+        }
+        FreeBlock *block = (FreeBlock*)__slab;
+        __slab += size;
+        block->next = list;
+        list = block;
+        ++count;
+    }
+    __cache.counts[cls] += count;
+    return list;
+}
+
+static void release(unsigned cls, unsigned count) noexcept {
+    FreeBlock *first = __cache.lists[cls];
+    FreeBlock *last = first;
+    for (unsigned i = 1; i < count; ++i) {
+        last = last->next;
+    }
+    __cache.lists[cls] = last->next;
+    __cache.counts[cls] -= count;
+
+    std::lock_guard<std::mutex> lock(__depotLock);
+    last->next = __depot[cls];
+    __depot[cls] = first;
+}
+
+void *mem_alloc(size_t size) noexcept {
+    if (size > MAX_SMALL) {
+        return std::malloc(size);
+    }
+    unsigned cls = size_class(size);
+    FreeBlock *block = __cache.lists[cls];
+    if (!block) {
+        block = refill(cls);
+        if (!block) {
+            return nullptr;
+        }
+    }
+    __cache.lists[cls] = block->next;
+    --__cache.counts[cls];
+    return block;
+}
+
+void mem_free(void *p, size_t size) noexcept {
+    if (!p) {
+        return;
+    }
+    if (size > MAX_SMALL) {
+        std::free(p);
+        return;
+    }
+    unsigned cls = size_class(size);
+    FreeBlock *block = (FreeBlock*)p;
+    block->next = __cache.lists[cls];
+    __cache.lists[cls] = block;
+    if (++__cache.counts[cls] > BATCH * 2) {
+        release(cls, BATCH);
+    }
+}
+
+void mem_flush() noexcept {
+    for (unsigned cls = 0; cls < CLASSES; ++cls) {
+        if (__cache.counts[cls]) {
+            release(cls, __cache.counts[cls]);
+        }
+    }
+}
+
+GV_NS_END
+
@@ -6,13 +6,23 @@
 
 GV_NS_BEGIN
 
-inline void *mem_alloc(size_t size) noexcept {
-    return std::malloc(size);
-}
-
-inline void mem_free(void *p, size_t size) noexcept {
-    return std::free(p);
-}
+/**
+ * @brief Allocates size bytes. Small sizes come, 16 bytes aligned,
+ *        from per size class free lists cached per thread, larger ones
+ *        from malloc.
+ */
+void *mem_alloc(size_t size) noexcept;
+
+/**
+ * @brief Releases p, size must be the one given to mem_alloc().
+ */
+void mem_free(void *p, size_t size) noexcept;
+
+/**
+ * @brief Hands the blocks cached by the calling thread back to the
+ *        shared pool, to call before a thread exits.
+ */
+void mem_flush() noexcept;
 
 GV_NS_END
 
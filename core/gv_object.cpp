@@ -5,8 +5,8 @@
 GV_NS_BEGIN
 
 Object::singletons Object::_singletons;
-int Object::_constructRef = 0;
-int Object::_destroyRef = 0;
+GV_THREAD_LOCAL int Object::_constructRef = 0;
+GV_THREAD_LOCAL int Object::_destroyRef = 0;
 
 Object::singletons::~singletons() {
     while (!_stack.empty()) {
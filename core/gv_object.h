@@ -2,8 +2,10 @@
 #define __GV_OBJECT_H__
 
 #include <stack>
+#include <atomic>
 
 #include "gv_platform.h"
+#include "gv_memory.h"
 #include "gv_list.h"
 
 GV_NS_BEGIN
@@ -12,6 +14,7 @@ class Object {
     template <typename> friend class object;
     template <typename> friend class ptr;
     template <typename, typename...> friend class singleton;
+    template <typename, bool> friend struct ref_policy;
     GV_FRIEND_LIST();
 protected:
     Object() noexcept : _ref(1) {
@@ -25,6 +28,18 @@ protected:
         }
     }
     virtual bool init() { return true;  }
+    /**
+     * @brief Called when the last reference is released, an object
+     *        returning true has kept itself for reuse and isn't deleted.
+     */
+    virtual bool recycle() noexcept { return false; }
+protected:
+    static void *operator new(std::size_t size) noexcept {
+        return mem_alloc(size);
+    }
+    static void operator delete(void *p, std::size_t size) noexcept {
+        mem_free(p, size);
+    }
 private:
     struct singletons {
         std::stack<Object*> _stack;
@@ -39,6 +54,9 @@ private:
         return new _T(std::forward<_Args>(args)...);
     }
     static void destroyObject(Object *obj) noexcept {
+        if (obj->recycle()) {
+            return;
+        }
         ++_destroyRef;
         delete obj;
     }
@@ -53,11 +71,64 @@ private:
         return obj;
     }
     mutable size_t _ref;
-    static int _constructRef;
-    static int _destroyRef;
+    static GV_THREAD_LOCAL int _constructRef;
+    static GV_THREAD_LOCAL int _destroyRef;
     static singletons _singletons;
 };
 
+/**
+ * @brief The base of the objects whose references may be taken and 
+ *        dropped from several threads, the reference count is atomic.
+ *        A ptr to a SharedObject class can't be converted to a ptr to
+ *        a class which isn't, the counting would differ.
+ */
+class SharedObject : public Object {
+    template <typename, bool> friend struct ref_policy;
+protected:
+    SharedObject() noexcept : _sharedRef(1) {}
+private:
+    mutable std::atomic<size_t> _sharedRef;
+};
+
+template <typename _T>
+struct is_shared_object {
+    static constexpr bool value = std::is_base_of<SharedObject, typename std::remove_cv<_T>::type>::value;
+};
+
+/* whether a _Tx pointer converted to a _T one would be counted differently */
+template <typename _T, typename _Tx>
+struct changes_ref_policy {
+    static constexpr bool value = std::is_base_of<_T, _Tx>::value && 
+        is_shared_object<_Tx>::value != is_shared_object<_T>::value;
+};
+
+template <typename _T, bool = is_shared_object<_T>::value>
+struct ref_policy {
+    static void retain(const Object *x) noexcept {
+        ++x->_ref;
+    }
+    static bool release(const Object *x) noexcept {
+        return !--x->_ref;
+    }
+    static size_t count(const Object *x) noexcept {
+        return x->_ref;
+    }
+};
+
+template <typename _T>
+struct ref_policy<_T, true> {
+    static void retain(const SharedObject *x) noexcept {
+        x->_sharedRef.fetch_add(1, std::memory_order_relaxed);
+    }
+    static bool release(const SharedObject *x) noexcept {
+        // the last owner must see the writes of the others
+        return x->_sharedRef.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+    static size_t count(const SharedObject *x) noexcept {
+        return x->_sharedRef.load(std::memory_order_relaxed);
+    }
+};
+
 template <typename _T>
 struct is_object {
     typedef typename std::remove_cv<_T> type;
@@ -98,24 +169,29 @@ private:
     }
     static void retain_ptr(type *x) noexcept {
         if (x) {
-            ++x->_ref;
+            ref_policy<_T>::retain(x);
         }
     }
     static void retain_ptr(const type *x) noexcept {
         if (x) {
-            ++x->_ref;
+            ref_policy<_T>::retain(x);
         }
     }
     static void release_ptr(type *x) noexcept {
-        if (x && !--x->_ref) {
+        if (x && ref_policy<_T>::release(x)) {
             Object::destroyObject(x);
         }
     }
     static void release_ptr(const type *x) noexcept {
-        if (x && !--x->_ref) {
+        if (x && ref_policy<_T>::release(x)) {
             Object::destroyObject(x);
         }
     }
+    template <typename _Tx>
+    static void check_policy() noexcept {
+        static_assert(is_shared_object<_Tx>::value == is_shared_object<_T>::value,
+                      "ptr can't convert between shared and unshared objects.");
+    }
     void retain() noexcept {
         retain_ptr(_ptr);
     }
@@ -136,8 +212,12 @@ public:
     ptr(type *x) noexcept : _ptr(x) {
         retain_ptr(x);
     }
+    template <typename _Tx, typename = typename std::enable_if<
+        changes_ref_policy<_T, _Tx>::value>::type>
+    ptr(_Tx *x) = delete;
     template <typename _Tx>
     ptr(const ptr<_Tx> &x) noexcept {
+        check_policy<_Tx>();
         retain_ptr(_ptr = x._ptr);
     }
     ptr(const ptr &x) noexcept {
@@ -153,6 +233,7 @@ public:
     }
     template <typename _Tx>
     void assign(const ptr<_Tx> &x) noexcept {
+        check_policy<_Tx>();
         if (reinterpret_cast<void*>(_ptr) == reinterpret_cast<void*>(x._ptr)) {
             return;
         }
@@ -173,6 +254,9 @@ public:
         retain_ptr(_ptr = x);
         return *this;
     }
+    template <typename _Tx, typename = typename std::enable_if<
+        changes_ref_policy<_T, _Tx>::value>::type>
+    ptr &operator=(_Tx *x) = delete;
     ptr &operator=(ptr &&x) noexcept {
         std::swap(_ptr, x._ptr);
         return *this;
@@ -193,9 +277,21 @@ public:
 
 template <typename _T1, typename _T2>
 inline ptr<_T1> ptr_cast(const ptr<_T2> &x) {
+    ptr<_T1>::template check_policy<_T2>();
     return x._ptr ? ptr<_T1>(static_cast<_T1*>(x._ptr)) : nullptr;
 }
 
+/**
+ * @brief The count of references held to the object, a cache may tell
+ *        from it whether it is the only holder. It is read through the
+ *        ptr, which can't hold a SharedObject as an unshared class, so
+ *        the counter read is the one the references are counted in.
+ */
+template <typename _T>
+inline size_t ref_count(const ptr<_T> &x) noexcept {
+    return x ? ref_policy<_T>::count(x.get()) : 0;
+}
+
 /**
  * 
  * 
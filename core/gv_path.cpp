@@ -10,7 +10,7 @@ GV_NS_BEGIN
 inline ptr<Path> PathPool::probe(ptr<Path> &parent, const char *name, unsigned len) noexcept {
     ptr<UniStr> str = unistr(name, len);
     ptr<Path> path;
-    auto em = _map.emplace(str, [&]() {
+    auto em = _map.emplace(key{parent, str}, [&]() {
         path = object<Path>();
         path->_name = str;
         path->_parent = parent;
@@ -43,7 +43,7 @@ ptr<Path> PathPool::get(const char *str, size_t len) noexcept {
         GETC();
     }
 
-    ptr<Path> &cur = _root;
+    ptr<Path> cur = _root;
     if (c == '/') {
         GETC();
     }
@@ -96,6 +96,12 @@ finish:
     return cur;
 }
 
+Path::~Path() noexcept {
+    if (_parent) {
+        PathPool::instance()->_map.erase(this);
+    }
+}
+
 std::string Path::name() const {
     std::string ret;
     if (this != PathPool::instance()->_root) {
@@ -22,6 +22,7 @@ public:
     }
 private:
     Path() : _parent() {}
+    ~Path() noexcept;
     map_entry _entry;
     ptr<UniStr> _name;
     ptr<Path> _parent;
@@ -41,12 +42,23 @@ private:
     ptr<Path> probe(ptr<Path> &parent, const char *name, unsigned len) noexcept;
     const ptr<Path> &current() noexcept;
 
+    /* a path is named in its parent, the pool doesn't own them */
+    struct key {
+        Path   *parent;
+        UniStr *name;
+    };
     struct compare {
-        int operator()(const ptr<UniStr> &lhs, const Path &rhs) const noexcept {
-            return lhs - rhs._name;
+        int operator()(const key &lhs, const Path &rhs) const noexcept {
+            if (lhs.parent != rhs._parent) {
+                return lhs.parent < rhs._parent ? -1 : 1;
+            }
+            if (lhs.name != rhs._name) {
+                return lhs.name < rhs._name ? -1 : 1;
+            }
+            return 0;
         }
     };
-    typedef gv_map(ptr<UniStr>, Path, _entry, compare) map_type;
+    typedef gv_map(key, Path, _entry, compare) map_type;
     map_type _map;
     object<Path> _root;
     std::stack<ptr<Path>> _stack;
@@ -1,9 +1,45 @@
 #include "opengxv.h"
+#include <cstring>
+#include <algorithm>
+#include <thread>
 #include "gv_pixel.h"
 #include "gv_chunk.h"
+#include "gv_pixelconvert.h"
 
 GV_NS_BEGIN
 
+enum {
+    BLOCK_PIXELS = 512,
+    /* the fewest rows a thread converts */
+    BAND_ROWS = 64,
+};
+
+static const unsigned char __bayer[4][4] = {
+    {0, 8, 2, 10},
+    {12, 4, 14, 6},
+    {3, 11, 1, 9},
+    {15, 7, 13, 5},
+};
+
+/* the bits the channels of format keep, nullptr if it keeps all or
+ * drops some, dithering doesn't apply then */
+static const unsigned char *ditherBits(PixelFormat format) noexcept {
+    static const unsigned char rgb565[4] = {5, 6, 5, 0};
+    static const unsigned char rgba4444[4] = {4, 4, 4, 4};
+    // a 1 bit alpha is a mask, left to the threshold
+    static const unsigned char rgba5551[4] = {5, 5, 5, 0};
+    switch (format) {
+    case PixelFormat::RGB565:
+        return rgb565;
+    case PixelFormat::RGBA4444:
+        return rgba4444;
+    case PixelFormat::RGBA5551:
+        return rgba5551;
+    default:
+        return nullptr;
+    }
+}
+
 PixelInfo::PixelInfo(PixelFormat format, const char *desc, bool compressed, bool alpha, size_t pixelSize, GLint glInternalFormat, GLenum glFormat, GLenum glType) 
 : _format(format),
   _desc(desc),
@@ -15,8 +51,254 @@ PixelInfo::PixelInfo(PixelFormat format, const char *desc, bool compressed, bool
   _glType(glType) 
 { }
 
+bool PixelInfo::convertible(PixelFormat to) const noexcept {
+    if (to >= PixelFormat::UNKNOWN || to == _format || (to == PixelFormat::A8 && !_alpha)) {
+        return false;
+    }
+    const PixelKernels &kernels = pixelKernels();
+    return (_format == PixelFormat::RGBA8888 || kernels.unpack[static_cast<size_t>(_format)]) &&
+        (to == PixelFormat::RGBA8888 || kernels.pack[static_cast<size_t>(to)]);
+}
+
+bool PixelInfo::convert(const void *src, void *dst, size_t count, PixelFormat to) const noexcept {
+    if (!convertible(to)) {
+        return false;
+    }
+    const PixelKernels &kernels = pixelKernels();
+    const unsigned char *s = (const unsigned char*)src;
+    unsigned char *d = (unsigned char*)dst;
+    if (_format == PixelFormat::RGBA8888) {
+        kernels.pack[static_cast<size_t>(to)](s, d, count);
+        return true;
+    }
+    PixelKernel unpack = kernels.unpack[static_cast<size_t>(_format)];
+    if (to == PixelFormat::RGBA8888) {
+        unpack(s, d, count);
+        return true;
+    }
+
+    // through RGBA8888, by blocks staying in the L1 cache
+    PixelKernel pack = kernels.pack[static_cast<size_t>(to)];
+    size_t dstSize = get(to)->pixelSize();
+    unsigned char block[BLOCK_PIXELS * 4];
+    for (size_t i = 0; i < count; i += BLOCK_PIXELS) {
+        size_t n = std::min(count - i, (size_t)BLOCK_PIXELS);
+        unpack(s + i * _pixelSize, block, n);
+        pack(block, d + i * dstSize, n);
+    }
+    return true;
+}
+
+PixelFormat PixelInfo::smallest(const void *data, size_t count, unsigned tolerance) const noexcept {
+    if (_format != PixelFormat::RGBA8888 && !convertible(PixelFormat::RGBA8888)) {
+        return _format;
+    }
+    const PixelKernels &kernels = pixelKernels();
+    const unsigned char *s = (const unsigned char*)data;
+    PixelStats stats{0xff};
+    if (_format == PixelFormat::RGBA8888) {
+        kernels.scan(s, count, stats);
+    }
+    else {
+        PixelKernel unpack = kernels.unpack[static_cast<size_t>(_format)];
+        unsigned char block[BLOCK_PIXELS * 4];
+        for (size_t i = 0; i < count; i += BLOCK_PIXELS) {
+            size_t n = std::min(count - i, (size_t)BLOCK_PIXELS);
+            unpack(s + i * _pixelSize, block, n);
+            kernels.scan(block, n, stats);
+        }
+    }
+
+    bool opaque = 0xffu - stats.alpha <= tolerance;
+    bool gray = stats.gray <= tolerance;
+    struct {
+        PixelFormat format;
+        bool fits;
+    } candidates[] = {
+        {PixelFormat::I8, opaque && gray},
+        {PixelFormat::AI88, gray},
+        {PixelFormat::RGB565, opaque && std::max(stats.rb5, stats.g6) <= tolerance},
+        {PixelFormat::RGBA5551, std::max(stats.alpha1, std::max(stats.rb5, stats.g5)) <= tolerance},
+        {PixelFormat::RGB888, opaque},
+    };
+    for (auto &candidate : candidates) {
+        if (candidate.fits) {
+            const PixelInfo *info = _infos[static_cast<size_t>(candidate.format)].get();
+            if (info->_pixelSize > _pixelSize) {
+                break;
+            }
+            if (info->support() && (candidate.format == _format || convertible(candidate.format))) {
+                return candidate.format;
+            }
+        }
+    }
+    return _format;
+}
+
+bool PixelInfo::premultiply(void *data, size_t count) const noexcept {
+    if (!_alpha || _format == PixelFormat::A8) {
+        return true;
+    }
+    const PixelKernels &kernels = pixelKernels();
+    unsigned char *p = (unsigned char*)data;
+    if (_format == PixelFormat::RGBA8888) {
+        kernels.premultiply(p, count);
+        return true;
+    }
+    PixelKernel unpack = kernels.unpack[static_cast<size_t>(_format)];
+    PixelKernel pack = kernels.pack[static_cast<size_t>(_format)];
+    if (_compressed || !unpack || !pack) {
+        return false;
+    }
+    // the formats narrower than RGBA8888 go through it by blocks
+    unsigned char block[BLOCK_PIXELS * 4];
+    for (size_t i = 0; i < count; i += BLOCK_PIXELS) {
+        size_t n = std::min(count - i, (size_t)BLOCK_PIXELS);
+        unpack(p + i * _pixelSize, block, n);
+        kernels.premultiply(block, n);
+        pack(block, p + i * _pixelSize, n);
+    }
+    return true;
+}
+
+bool PixelInfo::convert(const void *src, void *dst, unsigned width, unsigned height, PixelFormat to, PixelDither dither) const noexcept {
+    if (!convertible(to)) {
+        return false;
+    }
+    if (dither == PixelDither::NONE || !PixelConverter::dithers(to)) {
+        return convert(src, dst, (size_t)width * height, to);
+    }
+
+    size_t srcPitch = (size_t)width * _pixelSize;
+    size_t dstPitch = (size_t)width * get(to)->pixelSize();
+    auto band = [=](unsigned begin, unsigned end) {
+        PixelConverter converter(this, to, width, dither, begin);
+        for (unsigned y = begin; y < end; ++y) {
+            converter.convert((const unsigned char*)src + y * srcPitch, (unsigned char*)dst + y * dstPitch);
+        }
+    };
+    unsigned bands = std::max(1u, std::min(std::thread::hardware_concurrency(), height / BAND_ROWS));
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < bands; ++i) {
+        threads.emplace_back(band, height * i / bands, height * (i + 1) / bands);
+    }
+    band(0, height / bands);
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return true;
+}
+
 ptr<Chunk> PixelInfo::convert(const Chunk &src, PixelFormat to) const noexcept {
-    return nullptr;
+    if (!convertible(to)) {
+        return nullptr;
+    }
+    size_t count = src.size() / _pixelSize;
+    ptr<Chunk> dst = object<Chunk>(count * get(to)->pixelSize());
+    convert(src.data(), dst->data(), count, to);
+    return dst;
+}
+
+ptr<Chunk> PixelInfo::convert(const Chunk &src, unsigned width, unsigned height, PixelFormat to, PixelDither dither) const noexcept {
+    if (!convertible(to)) {
+        return nullptr;
+    }
+    ptr<Chunk> dst = object<Chunk>((size_t)width * height * get(to)->pixelSize());
+    convert(src.data(), dst->data(), width, height, to, dither);
+    return dst;
+}
+
+/* PixelConverter */
+PixelConverter::PixelConverter(const PixelInfo *from, PixelFormat to, unsigned width, PixelDither dither, unsigned y) noexcept
+: _from(from),
+  _to(to),
+  _width(width),
+  _dither(dithers(to) ? dither : PixelDither::NONE),
+  _y(y),
+  _bits(),
+  _table()
+{
+    if (_dither == PixelDither::NONE) {
+        return;
+    }
+    std::memcpy(_bits, ditherBits(to), sizeof(_bits));
+    _rgba.resize((size_t)width * 4);
+    if (_dither == PixelDither::DIFFUSION) {
+        _errors[0].resize(((size_t)width + 2) * 4);
+        _errors[1].resize(((size_t)width + 2) * 4);
+        return;
+    }
+
+    // a threshold below the step of each channel, after taking off the
+    // bits the widening repeats so that the exact levels are kept
+    for (unsigned row = 0; row < 4; ++row) {
+        for (unsigned x = 0; x < 4; ++x) {
+            for (unsigned c = 0; c < 4; ++c) {
+                unsigned bits = _bits[c];
+                if (bits) {
+                    _table[row][x * 4 + c] = __bayer[row][x] >> (bits - 4);
+                    _table[row][(bits - 3) * 16 + x * 4 + c] = 0xff >> bits;
+                }
+            }
+        }
+    }
+}
+
+bool PixelConverter::dithers(PixelFormat format) noexcept {
+    return ditherBits(format) != nullptr;
+}
+
+void PixelConverter::convert(const void *src, void *dst) noexcept {
+    if (_dither == PixelDither::NONE) {
+        _from->convert(src, dst, _width, _to);
+        ++_y;
+        return;
+    }
+
+    const PixelKernels &kernels = pixelKernels();
+    unsigned char *rgba = _rgba.data();
+    if (_from->format() == PixelFormat::RGBA8888) {
+        std::memcpy(rgba, src, _rgba.size());
+    }
+    else {
+        kernels.unpack[static_cast<size_t>(_from->format())]((const unsigned char*)src, rgba, _width);
+    }
+    if (_dither == PixelDither::ORDERED) {
+        kernels.ordered(rgba, _width, _table[_y & 3]);
+    }
+    else {
+        diffuse();
+    }
+    kernels.pack[static_cast<size_t>(_to)](rgba, (unsigned char*)dst, _width);
+    ++_y;
+}
+
+/* each channel, with the error carried in, is set to the nearest
+ * level. What that leaves out is spread over the pixels not done yet,
+ * 7/16 right, then 3/16, 5/16 and 1/16 below */
+void PixelConverter::diffuse() noexcept {
+    short *cur = _errors[_y & 1].data() + 4;
+    short *next = _errors[(_y + 1) & 1].data() + 4;
+    std::fill(_errors[(_y + 1) & 1].begin(), _errors[(_y + 1) & 1].end(), 0);
+    unsigned char *p = _rgba.data();
+    for (unsigned x = 0; x < _width; ++x, p += 4, cur += 4, next += 4) {
+        for (int c = 0; c < 4; ++c) {
+            unsigned bits = _bits[c];
+            if (!bits) {
+                continue;
+            }
+            int v = std::min(std::max(p[c] + cur[c], 0), 0xff);
+            unsigned max = (1u << bits) - 1;
+            unsigned q = ((v * max + 127) / 0xff) << (8 - bits);
+            q |= q >> bits;
+            int error = v - (int)q;
+            p[c] = (unsigned char)q;
+            cur[c + 4] += error * 7 / 16;
+            next[c - 4] += error * 3 / 16;
+            next[c] += error * 5 / 16;
+            next[c + 4] += error / 16;
+        }
+    }
 }
 
 #define INFO_CONSTRUCTOR(x, z, a, s, ifmt, f, t) PixelInfo##x() : PixelInfo(PixelFormat::x, #x, z, a, s, ifmt, f, t) {}
@@ -27,348 +309,21 @@ struct PixelInfoA8 : PixelInfo {
 struct PixelInfoI8 : PixelInfo {
     INFO_CONSTRUCTOR(I8, false, false, 1, GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE);
 
-    virtual ptr<Chunk> convert(const Chunk &src, PixelFormat to) const noexcept override {
-        size_t size = src.size();
-        unsigned char *s = src.data();
-        unsigned char *end = s + src.size();
-        ptr<Chunk> dst;
-        switch (to) {
-        case PixelFormat::AI88:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = 0xff00 | *s++;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB888: 
-            do {
-                dst = object<Chunk>(size * 3);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s;
-                    *d++ = *s;
-                    *d++ = *s++;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA8888:
-            do {
-	            dst = object<Chunk>(size * 4);
-	            unsigned char *d = dst->data();
-	            while (s < end) {
-	                *d++ = *s;
-	                *d++ = *s;
-	                *d++ = *s++;
-	                *d++ = 0xff;
-	            }
-            } while (0);
-            break;
-        case PixelFormat::RGB565:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s++;
-                    *d++ = ((c & 0xf8) << 8) | ((c & 0xfc) << 3) | ((c & 0xf8) >> 3);
-                }
-
-            } while (0);
-            break;
-        case PixelFormat::RGBA4444:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s++;
-                    *d++ = ((c & 0xf0) << 8) | ((c & 0xf0) << 4) | (c & 0xf0) | 0xf;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA5551:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s++;
-                    *d++ = ((c & 0xf8) << 8) | ((c & 0xf8) << 3) | ((c & 0xf8) >> 2) | 1;
-                }
-            } while (0);
-            break;
-        default:
-            return nullptr;
-        }
-        return dst;
-    }
 };
 
 struct PixelInfoAI88 : PixelInfo {
     INFO_CONSTRUCTOR(AI88, false, true, 2, GL_LUMINANCE_ALPHA, GL_LUMINANCE_ALPHA, GL_UNSIGNED_BYTE);
 
-    virtual ptr<Chunk> convert(const Chunk &src, PixelFormat to) const noexcept override {
-        size_t size = src.size();
-        unsigned char *s = src.data();
-        unsigned char *end = s + src.size();
-        ptr<Chunk> dst;
-        size >>= 1;
-        switch (to) {
-        case PixelFormat::A8:
-            do {
-                dst = object<Chunk>(size);
-                unsigned char *d = dst->data();
-                s++;
-                while (s < end) {
-                    *d++ = *s;
-                    s += 2;
-                }
-            } while (0);
-            break;
-        case PixelFormat::I8:
-            do {
-                dst = object<Chunk>(size);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s;
-                    s += 2;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB888:
-            do {
-                dst = object<Chunk>(size * 3);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s;
-                    *d++ = *s;
-                    *d++ = *s++;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA8888:
-            do {
-                dst = object<Chunk>(size * 4);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s;
-                    *d++ = *s;
-                    *d++ = *s++;
-                    *d++ = *s++;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB565:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s;
-                    *d++ = ((c & 0xf8) << 8) | ((c & 0xfc) << 3) | ((c & 0xf8) >> 3);
-                    s += 2;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA4444:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s++;
-                    *d++ = ((c & 0xf0) << 8) | ((c & 0xf0) << 4) | ((c & 0xf0)) | ((*s++ & 0xf0) >> 4);
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA5551:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                unsigned int c;
-                while (s < end) {
-                    c = *s++;
-                    *d++ = ((c & 0xf8) << 8) | ((c & 0xf8) << 3) | ((c & 0xf8) >> 2) | ((*s++ & 0x80) >> 7);
-                }
-            } while (0);
-            break;
-        default:
-            return nullptr;
-        }
-        return dst;
-    }
 };
 
 struct PixelInfoRGB888 : PixelInfo {
     INFO_CONSTRUCTOR(RGB888, false, false, 3, GL_RGB, GL_RGB, GL_UNSIGNED_BYTE);
 
-    virtual ptr<Chunk> convert(const Chunk &src, PixelFormat to) const noexcept override {
-        size_t size = src.size();
-        unsigned char *s = src.data();
-        unsigned char *end = s + src.size();
-        ptr<Chunk> dst;
-        size /= 3;
-        switch (to) {
-        case PixelFormat::I8:
-            do {
-                dst = object<Chunk>(size);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = (s[0] * 299 + s[1] * 587 + s[2] * 114 + 500) / 1000;
-                    s += 3;
-                }
-            } while (0);
-            break;
-        case PixelFormat::AI88:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = 0xff00 | ((s[0] * 299 + s[1] * 587 + s[2] * 114 + 500) / 1000);
-                    s += 3;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA8888:
-            do {
-                dst = object<Chunk>(size * 4);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s++;
-                    *d++ = *s++;
-                    *d++ = *s++;
-                    *d++ = 0xFF;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB565:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] & 0xf8) << 8) | ((s[1] & 0xfc) << 3) | ((s[2] & 0xf8) >> 3);
-                    s += 3;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA4444:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] & 0xf0) << 8) | ((s[1] & 0xf0) << 4) | (s[2] & 0xf0) | 0xf;
-                    s += 3;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA5551:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] & 0xf8) << 8) | ((s[1] & 0xf8) << 3) | ((s[2] & 0xf8) >> 2) | 1;
-                    s += 3;
-                }
-            } while (0);
-            break;
-        default:
-            return nullptr;
-        }
-        return dst;
-    }
 };
 
 struct PixelInfoRGBA8888 : PixelInfo {
     INFO_CONSTRUCTOR(RGBA8888, false, true, 4, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE);
 
-    virtual ptr<Chunk> convert(const Chunk &src, PixelFormat to) const noexcept override {
-        size_t size = src.size();
-        unsigned char *s = src.data();
-        unsigned char *end = s + src.size();
-        ptr<Chunk> dst;
-        size >>= 2;
-        switch (to) {
-        case PixelFormat::A8:
-            do {
-                dst = object<Chunk>(size);
-                unsigned char *d = dst->data();
-                s += 3;
-                while (s < end) {
-                    *d++ = *s;
-                    s += 4;
-                }
-            } while (0);
-            break;
-        case PixelFormat::I8:
-            do {
-                dst = object<Chunk>(size);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = (s[0] * 299 + s[1] * 587 + s[2] * 114 + 500) / 1000;
-                    s += 4;
-                }
-            } while (0);
-            break;
-        case PixelFormat::AI88:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] * 299 + s[1] * 587 + s[2] * 114 + 500) / 1000);
-                    *d++ = s[4];
-                    s += 4;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB888:
-            do {
-                dst = object<Chunk>(size * 3);
-                unsigned char *d = dst->data();
-                while (s < end) {
-                    *d++ = *s++;
-                    *d++ = *s++;
-                    *d++ = *s;
-                    s += 2;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGB565:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[1] & 0xf8) << 8) | ((s[2] & 0xfc) << 3) | ((s[3] & 0xf8) >> 3);
-                    s += 4;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA4444:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] & 0xf0) << 8) | ((s[1] & 0xf0) << 4) | (s[2] & 0xf0) | ((s[3] & 0xf0) >> 4);
-                    s += 4;
-                }
-            } while (0);
-            break;
-        case PixelFormat::RGBA5551:
-            do {
-                dst = object<Chunk>(size * 2);
-                unsigned short *d = (unsigned short*)dst->data();
-                while (s < end) {
-                    *d++ = ((s[0] & 0xf8) << 8) | ((s[1] & 0xf8) << 3) | ((s[2] & 0xf8) >> 2) | ((s[3] & 0x80) >> 7);
-                    s += 4;
-                }
-            } while (0);
-            break;
-        default:
-            return nullptr;
-        }
-        return dst;
-    }
 };
 
 struct PixelInfoRGB565 : PixelInfo {
@@ -1,6 +1,8 @@
 #ifndef __GV_PIXEL_H__
 #define __GV_PIXEL_H__
 
+#include <vector>
+
 #include "gv_object.h"
 #include "gv_log.h"
 
@@ -20,8 +22,40 @@ enum class PixelFormat {
     UNKNOWN,
 };
 
-struct PixelInfo : Object {
+/* how the 16 bits formats round the channels they shorten */
+enum class PixelDither {
+    NONE,       /* truncated */
+    ORDERED,    /* by a 4x4 Bayer pattern */
+    DIFFUSION,  /* Floyd-Steinberg */
+};
+
+/* shared, the decoders running on the loader threads take references */
+struct PixelInfo : SharedObject {
     virtual ptr<Chunk> convert(const Chunk &src, PixelFormat to) const noexcept;
+    /**
+     * @brief Converts count pixels into dst, which has room for them in
+     *        format to. Returns false if the conversion isn't supported.
+     */
+    bool convert(const void *src, void *dst, size_t count, PixelFormat to) const noexcept;
+    /**
+     * @brief Converts an image of width x height pixels with dither.
+     *        Large ones are converted by bands on several threads, the
+     *        diffused error doesn't cross the bands.
+     */
+    bool convert(const void *src, void *dst, unsigned width, unsigned height, PixelFormat to, PixelDither dither) const noexcept;
+    ptr<Chunk> convert(const Chunk &src, unsigned width, unsigned height, PixelFormat to, PixelDither dither) const noexcept;
+    bool convertible(PixelFormat to) const noexcept;
+    /**
+     * @brief The smallest supported format holding count pixels of data
+     *        with no channel off by more than tolerance, 0 is lossless.
+     */
+    PixelFormat smallest(const void *data, size_t count, unsigned tolerance) const noexcept;
+    /**
+     * @brief Multiplies the colors of count pixels by their alpha in
+     *        place. Returns false if the format isn't supported, the
+     *        formats without alpha are left as they are.
+     */
+    bool premultiply(void *data, size_t count) const noexcept;
 
     virtual bool support() const noexcept {
         return true;
@@ -70,6 +104,42 @@ protected:
     GLenum _glType;
 };
 
+/**
+ * @brief Converts an image row after row, top down, so that the error
+ *        diffusion and the pattern follow the rows. The conversion must
+ *        be convertible().
+ */
+class PixelConverter {
+public:
+    PixelConverter(const PixelInfo *from, PixelFormat to, unsigned width, PixelDither dither, unsigned y = 0) noexcept;
+
+    /**
+     * @brief Whether dither changes the conversion to format.
+     */
+    static bool dithers(PixelFormat format) noexcept;
+    /**
+     * @brief Converts the next row.
+     */
+    void convert(const void *src, void *dst) noexcept;
+
+private:
+    void diffuse() noexcept;
+
+    const PixelInfo           *_from;
+    PixelFormat                _to;
+    unsigned                   _width;
+    PixelDither                _dither;
+    unsigned                   _y;
+    /* the bits each channel keeps, 0 if left alone */
+    unsigned char              _bits[4];
+    /* of the ordered dither, a row of the pattern each */
+    unsigned char              _table[4][64];
+    std::vector<unsigned char> _rgba;
+    /* the error carried into this row and the next, a pixel of margin
+     * on both sides */
+    std::vector<short>         _errors[2];
+};
+
 struct PixelFormatInfo {
 
     PixelFormatInfo(GLenum anInternalFormat, GLenum aFormat, GLenum aType, int aBpp, bool aCompressed, bool anAlpha)
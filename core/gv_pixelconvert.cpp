@@ -0,0 +1,980 @@
+#include "opengxv.h"
+#include <cstring>
+#include <algorithm>
+#include "gv_pixelconvert.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define GV_PIXEL_X86    1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GV_PIXEL_NEON   1
+#include <arm_neon.h>
+#endif
+
+/* lets the x86 kernels use instructions the build doesn't enable */
+#if defined(__GNUC__)
+#define GV_TARGET(x)    __attribute__((target(x)))
+#else
+#define GV_TARGET(x)
+#endif
+#define GV_SSE2         GV_TARGET("sse2")
+#define GV_AVX2         GV_TARGET("avx2")
+
+GV_NS_BEGIN
+
+/* luminance, 8 bits fixed point BT.601 weights summing to 256 so that
+ * a gray pixel keeps its level */
+enum {
+    LUM_R = 77,
+    LUM_G = 150,
+    LUM_B = 29,
+};
+
+static inline unsigned luminance(const unsigned char *s) noexcept {
+    return (s[0] * LUM_R + s[1] * LUM_G + s[2] * LUM_B + 128) >> 8;
+}
+
+static inline void store16(unsigned char *d, unsigned short v) noexcept {
+    std::memcpy(d, &v, 2);
+}
+
+/* the packers, one RGBA8888 pixel to a 16 bits one */
+struct PackAI88 {
+    static unsigned short scalar(const unsigned char *s) noexcept {
+        return (unsigned short)(luminance(s) | (s[3] << 8));
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+struct PackRGB565 {
+    static unsigned short scalar(const unsigned char *s) noexcept {
+        return (unsigned short)(((s[0] & 0xf8) << 8) | ((s[1] & 0xfc) << 3) | (s[2] >> 3));
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+struct PackRGBA4444 {
+    static unsigned short scalar(const unsigned char *s) noexcept {
+        return (unsigned short)(((s[0] & 0xf0) << 8) | ((s[1] & 0xf0) << 4) | (s[2] & 0xf0) | (s[3] >> 4));
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+struct PackRGBA5551 {
+    static unsigned short scalar(const unsigned char *s) noexcept {
+        return (unsigned short)(((s[0] & 0xf8) << 8) | ((s[1] & 0xf8) << 3) | ((s[2] & 0xf8) >> 2) | (s[3] >> 7));
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+/* and to a 8 bits one */
+struct PackA8 {
+    static unsigned char scalar(const unsigned char *s) noexcept {
+        return s[3];
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+struct PackI8 {
+    static unsigned char scalar(const unsigned char *s) noexcept {
+        return (unsigned char)luminance(s);
+    }
+#if GV_PIXEL_X86
+    static GV_SSE2 __m128i sse2(__m128i x) noexcept;
+    static GV_AVX2 __m256i avx2(__m256i x) noexcept;
+#endif
+};
+
+/* scalar */
+template <typename _Pack>
+static void scalarPack8(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n * 4; s < end; s += 4) {
+        *d++ = _Pack::scalar(s);
+    }
+}
+
+template <typename _Pack>
+static void scalarPack16(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n * 4; s < end; s += 4, d += 2) {
+        store16(d, _Pack::scalar(s));
+    }
+}
+
+static void scalarPackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n * 4; s < end; s += 4) {
+        *d++ = s[0];
+        *d++ = s[1];
+        *d++ = s[2];
+    }
+}
+
+static void scalarUnpackI8(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n; s < end; ++s) {
+        *d++ = *s;
+        *d++ = *s;
+        *d++ = *s;
+        *d++ = 0xff;
+    }
+}
+
+static void scalarUnpackAI88(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n * 2; s < end; s += 2) {
+        *d++ = s[0];
+        *d++ = s[0];
+        *d++ = s[0];
+        *d++ = s[1];
+    }
+}
+
+static void scalarUnpackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    for (const unsigned char *end = s + n * 3; s < end; s += 3) {
+        *d++ = s[0];
+        *d++ = s[1];
+        *d++ = s[2];
+        *d++ = 0xff;
+    }
+}
+
+/* the error of c truncated to its high bits, then widened again by
+ * repeating them as gl does */
+static inline unsigned char quantizeError(unsigned c, unsigned bits) noexcept {
+    unsigned q = c & (0xff << (8 - bits)) & 0xff;
+    q |= q >> bits;
+    return (unsigned char)(c > q ? c - q : q - c);
+}
+
+static inline unsigned char distance(unsigned a, unsigned b) noexcept {
+    return (unsigned char)(a > b ? a - b : b - a);
+}
+
+static void scalarScan(const unsigned char *s, size_t n, PixelStats &stats) {
+    for (const unsigned char *end = s + n * 4; s < end; s += 4) {
+        stats.alpha = std::min(stats.alpha, s[3]);
+        stats.alpha1 = std::max(stats.alpha1, std::min(s[3], (unsigned char)(0xff - s[3])));
+        stats.gray = std::max(stats.gray, std::max(distance(s[0], s[1]), distance(s[1], s[2])));
+        stats.rb5 = std::max(stats.rb5, std::max(quantizeError(s[0], 5), quantizeError(s[2], 5)));
+        stats.g5 = std::max(stats.g5, quantizeError(s[1], 5));
+        stats.g6 = std::max(stats.g6, quantizeError(s[1], 6));
+    }
+}
+
+static void scalarOrdered(unsigned char *p, size_t n, const unsigned char *table) {
+    for (size_t i = 0; i < n * 4; ++i) {
+        unsigned k = i & 15;
+        unsigned c = p[i];
+        c -= ((c >> 4) & table[16 + k]) | ((c >> 5) & table[32 + k]) | ((c >> 6) & table[48 + k]);
+        p[i] = (unsigned char)std::min(c + table[k], 0xffu);
+    }
+}
+
+/* c * a / 255 rounded, exact for bytes */
+static inline unsigned char mul255(unsigned c, unsigned a) noexcept {
+    unsigned t = c * a + 128;
+    return (unsigned char)((t + (t >> 8)) >> 8);
+}
+
+static void scalarPremultiply(unsigned char *p, size_t n) {
+    for (unsigned char *end = p + n * 4; p < end; p += 4) {
+        unsigned a = p[3];
+        p[0] = mul255(p[0], a);
+        p[1] = mul255(p[1], a);
+        p[2] = mul255(p[2], a);
+    }
+}
+
+/* folds the byte accumulators of a vector scan, laid out as its RGBA
+ * pixels are */
+static void mergeScan(const unsigned char *alpha, const unsigned char *alpha1, const unsigned char *gray,
+                      const unsigned char *max5, const unsigned char *max6, size_t size, PixelStats &stats) noexcept {
+    for (size_t i = 0; i < size; i += 4) {
+        stats.alpha = std::min(stats.alpha, alpha[i + 3]);
+        stats.alpha1 = std::max(stats.alpha1, alpha1[i + 3]);
+        stats.gray = std::max(stats.gray, std::max(gray[i], gray[i + 1]));
+        stats.rb5 = std::max(stats.rb5, std::max(max5[i], max5[i + 2]));
+        stats.g5 = std::max(stats.g5, max5[i + 1]);
+        stats.g6 = std::max(stats.g6, max6[i + 1]);
+    }
+}
+
+static const PixelKernels __scalarKernels = {
+    PixelIsa::SCALAR, "scalar",
+    {
+        nullptr,
+        scalarUnpackI8,
+        scalarUnpackAI88,
+        scalarUnpackRGB888,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+    },
+    {
+        scalarPack8<PackA8>,
+        scalarPack8<PackI8>,
+        scalarPack16<PackAI88>,
+        scalarPackRGB888,
+        nullptr,
+        scalarPack16<PackRGB565>,
+        scalarPack16<PackRGBA4444>,
+        scalarPack16<PackRGBA5551>,
+    },
+    scalarScan,
+    scalarOrdered,
+    scalarPremultiply,
+};
+
+#if GV_PIXEL_X86
+/* SSE2, 4 pixels a register, the 32 bits lanes hold the results */
+GV_SSE2 __m128i PackRGB565::sse2(__m128i x) noexcept {
+    __m128i r = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xf8)), 8);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(x, 5), _mm_set1_epi32(0x7e0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(x, 19), _mm_set1_epi32(0x1f));
+    return _mm_or_si128(_mm_or_si128(r, g), b);
+}
+
+GV_SSE2 __m128i PackRGBA4444::sse2(__m128i x) noexcept {
+    __m128i r = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xf0)), 8);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(x, 4), _mm_set1_epi32(0xf00));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(x, 16), _mm_set1_epi32(0xf0));
+    __m128i a = _mm_srli_epi32(x, 28);
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+GV_SSE2 __m128i PackRGBA5551::sse2(__m128i x) noexcept {
+    __m128i r = _mm_slli_epi32(_mm_and_si128(x, _mm_set1_epi32(0xf8)), 8);
+    __m128i g = _mm_and_si128(_mm_srli_epi32(x, 5), _mm_set1_epi32(0x7c0));
+    __m128i b = _mm_and_si128(_mm_srli_epi32(x, 18), _mm_set1_epi32(0x3e));
+    __m128i a = _mm_srli_epi32(x, 31);
+    return _mm_or_si128(_mm_or_si128(r, g), _mm_or_si128(b, a));
+}
+
+GV_SSE2 __m128i PackA8::sse2(__m128i x) noexcept {
+    return _mm_srli_epi32(x, 24);
+}
+
+/* r and b, then g and a, as 16 bits pairs multiplied and summed */
+GV_SSE2 __m128i PackI8::sse2(__m128i x) noexcept {
+    __m128i mask = _mm_set1_epi32(0x00ff00ff);
+    __m128i rb = _mm_and_si128(x, mask);
+    __m128i ga = _mm_and_si128(_mm_srli_epi32(x, 8), mask);
+    __m128i sum = _mm_add_epi32(
+        _mm_madd_epi16(rb, _mm_set1_epi32((LUM_B << 16) | LUM_R)),
+        _mm_madd_epi16(ga, _mm_set1_epi32(LUM_G)));
+    return _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(128)), 8);
+}
+
+GV_SSE2 __m128i PackAI88::sse2(__m128i x) noexcept {
+    __m128i a = _mm_slli_epi32(_mm_srli_epi32(x, 24), 8);
+    return _mm_or_si128(PackI8::sse2(x), a);
+}
+
+/* the saturating pack is signed, the lanes are sign extended first */
+static inline GV_SSE2 __m128i sse2Narrow16(__m128i a, __m128i b) noexcept {
+    a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+    b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+    return _mm_packs_epi32(a, b);
+}
+
+template <typename _Pack>
+static GV_SSE2 void sse2Pack16(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i x0 = _mm_loadu_si128((const __m128i*)(s + i * 4));
+        __m128i x1 = _mm_loadu_si128((const __m128i*)(s + i * 4 + 16));
+        _mm_storeu_si128((__m128i*)(d + i * 2), sse2Narrow16(_Pack::sse2(x0), _Pack::sse2(x1)));
+    }
+    scalarPack16<_Pack>(s + i * 4, d + i * 2, n - i);
+}
+
+template <typename _Pack>
+static GV_SSE2 void sse2Pack8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i *p = (const __m128i*)(s + i * 4);
+        __m128i lo = _mm_packs_epi32(_Pack::sse2(_mm_loadu_si128(p)), _Pack::sse2(_mm_loadu_si128(p + 1)));
+        __m128i hi = _mm_packs_epi32(_Pack::sse2(_mm_loadu_si128(p + 2)), _Pack::sse2(_mm_loadu_si128(p + 3)));
+        _mm_storeu_si128((__m128i*)(d + i), _mm_packus_epi16(lo, hi));
+    }
+    scalarPack8<_Pack>(s + i * 4, d + i, n - i);
+}
+
+static GV_SSE2 void sse2UnpackI8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m128i ff = _mm_set1_epi8((char)0xff);
+    for (; i + 16 <= n; i += 16) {
+        __m128i l = _mm_loadu_si128((const __m128i*)(s + i));
+        __m128i ll = _mm_unpacklo_epi8(l, l);
+        __m128i la = _mm_unpacklo_epi8(l, ff);
+        __m128i *p = (__m128i*)(d + i * 4);
+        _mm_storeu_si128(p, _mm_unpacklo_epi16(ll, la));
+        _mm_storeu_si128(p + 1, _mm_unpackhi_epi16(ll, la));
+        ll = _mm_unpackhi_epi8(l, l);
+        la = _mm_unpackhi_epi8(l, ff);
+        _mm_storeu_si128(p + 2, _mm_unpacklo_epi16(ll, la));
+        _mm_storeu_si128(p + 3, _mm_unpackhi_epi16(ll, la));
+    }
+    scalarUnpackI8(s + i, d + i * 4, n - i);
+}
+
+static GV_SSE2 void sse2UnpackAI88(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i la = _mm_loadu_si128((const __m128i*)(s + i * 2));
+        __m128i l = _mm_and_si128(la, _mm_set1_epi16(0xff));
+        __m128i ll = _mm_or_si128(l, _mm_slli_epi16(l, 8));
+        __m128i *p = (__m128i*)(d + i * 4);
+        _mm_storeu_si128(p, _mm_unpacklo_epi16(ll, la));
+        _mm_storeu_si128(p + 1, _mm_unpackhi_epi16(ll, la));
+    }
+    scalarUnpackAI88(s + i * 2, d + i * 4, n - i);
+}
+
+static inline GV_SSE2 __m128i sse2Distance(__m128i a, __m128i b) noexcept {
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+/* bytes truncated to 8 - __shift bits and widened back, the 16 bits
+ * shift carries bits over from the next byte, masked off */
+template <int __shift>
+static inline GV_SSE2 __m128i sse2Quantize(__m128i x) noexcept {
+    __m128i q = _mm_and_si128(x, _mm_set1_epi8((char)(0xff << __shift)));
+    __m128i low = _mm_and_si128(_mm_srli_epi16(q, 8 - __shift), _mm_set1_epi8((char)(0xff >> (8 - __shift))));
+    return sse2Distance(x, _mm_or_si128(q, low));
+}
+
+static GV_SSE2 void sse2Scan(const unsigned char *s, size_t n, PixelStats &stats) {
+    size_t i = 0;
+    __m128i alpha = _mm_set1_epi8((char)0xff);
+    __m128i alpha1 = _mm_setzero_si128();
+    __m128i gray = _mm_setzero_si128();
+    __m128i max5 = _mm_setzero_si128();
+    __m128i max6 = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + i * 4));
+        alpha = _mm_min_epu8(alpha, x);
+        alpha1 = _mm_max_epu8(alpha1, _mm_min_epu8(x, _mm_xor_si128(x, _mm_set1_epi8((char)0xff))));
+        gray = _mm_max_epu8(gray, sse2Distance(x, _mm_srli_epi32(x, 8)));
+        max5 = _mm_max_epu8(max5, sse2Quantize<3>(x));
+        max6 = _mm_max_epu8(max6, sse2Quantize<2>(x));
+    }
+    unsigned char bytes[5][16];
+    _mm_storeu_si128((__m128i*)bytes[0], alpha);
+    _mm_storeu_si128((__m128i*)bytes[1], alpha1);
+    _mm_storeu_si128((__m128i*)bytes[2], gray);
+    _mm_storeu_si128((__m128i*)bytes[3], max5);
+    _mm_storeu_si128((__m128i*)bytes[4], max6);
+    mergeScan(bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], 16, stats);
+    scalarScan(s + i * 4, n - i, stats);
+}
+
+/* 4 pixels a register, as many as the table holds */
+static GV_SSE2 void sse2Ordered(unsigned char *p, size_t n, const unsigned char *table) {
+    size_t i = 0;
+    __m128i threshold = _mm_loadu_si128((const __m128i*)table);
+    __m128i mask4 = _mm_loadu_si128((const __m128i*)(table + 16));
+    __m128i mask5 = _mm_loadu_si128((const __m128i*)(table + 32));
+    __m128i mask6 = _mm_loadu_si128((const __m128i*)(table + 48));
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i * 4));
+        __m128i low = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 4), mask4),
+            _mm_or_si128(_mm_and_si128(_mm_srli_epi16(x, 5), mask5), _mm_and_si128(_mm_srli_epi16(x, 6), mask6)));
+        _mm_storeu_si128((__m128i*)(p + i * 4), _mm_adds_epu8(_mm_sub_epi8(x, low), threshold));
+    }
+    scalarOrdered(p + i * 4, n - i, table);
+}
+
+/* mul255() of the 16 bits lanes */
+static inline GV_SSE2 __m128i sse2Mul255(__m128i x, __m128i a) noexcept {
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(x, a), _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+/* the alpha of each pixel is spread over its 4 lanes, but the alpha
+ * lane itself, set to 255 so that it's kept */
+static inline GV_SSE2 __m128i sse2Alpha(__m128i x, __m128i opaque) noexcept {
+    return _mm_or_si128(_mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xff), 0xff), opaque);
+}
+
+static GV_SSE2 void sse2Premultiply(unsigned char *p, size_t n) {
+    size_t i = 0;
+    __m128i zero = _mm_setzero_si128();
+    __m128i opaque = _mm_set_epi16(0xff, 0, 0, 0, 0xff, 0, 0, 0);
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i*)(p + i * 4));
+        __m128i lo = _mm_unpacklo_epi8(x, zero);
+        __m128i hi = _mm_unpackhi_epi8(x, zero);
+        lo = sse2Mul255(lo, sse2Alpha(lo, opaque));
+        hi = sse2Mul255(hi, sse2Alpha(hi, opaque));
+        _mm_storeu_si128((__m128i*)(p + i * 4), _mm_packus_epi16(lo, hi));
+    }
+    scalarPremultiply(p + i * 4, n - i);
+}
+
+/* SSE2 has no byte shuffle, RGB888 stays scalar */
+static const PixelKernels __sse2Kernels = {
+    PixelIsa::SSE2, "sse2",
+    {
+        nullptr,
+        sse2UnpackI8,
+        sse2UnpackAI88,
+        scalarUnpackRGB888,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+    },
+    {
+        sse2Pack8<PackA8>,
+        sse2Pack8<PackI8>,
+        sse2Pack16<PackAI88>,
+        scalarPackRGB888,
+        nullptr,
+        sse2Pack16<PackRGB565>,
+        sse2Pack16<PackRGBA4444>,
+        sse2Pack16<PackRGBA5551>,
+    },
+    sse2Scan,
+    sse2Ordered,
+    sse2Premultiply,
+};
+
+/* AVX2, 8 pixels a register */
+GV_AVX2 __m256i PackRGB565::avx2(__m256i x) noexcept {
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xf8)), 8);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(x, 5), _mm256_set1_epi32(0x7e0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(x, 19), _mm256_set1_epi32(0x1f));
+    return _mm256_or_si256(_mm256_or_si256(r, g), b);
+}
+
+GV_AVX2 __m256i PackRGBA4444::avx2(__m256i x) noexcept {
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xf0)), 8);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(x, 4), _mm256_set1_epi32(0xf00));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(x, 16), _mm256_set1_epi32(0xf0));
+    __m256i a = _mm256_srli_epi32(x, 28);
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+}
+
+GV_AVX2 __m256i PackRGBA5551::avx2(__m256i x) noexcept {
+    __m256i r = _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0xf8)), 8);
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(x, 5), _mm256_set1_epi32(0x7c0));
+    __m256i b = _mm256_and_si256(_mm256_srli_epi32(x, 18), _mm256_set1_epi32(0x3e));
+    __m256i a = _mm256_srli_epi32(x, 31);
+    return _mm256_or_si256(_mm256_or_si256(r, g), _mm256_or_si256(b, a));
+}
+
+GV_AVX2 __m256i PackA8::avx2(__m256i x) noexcept {
+    return _mm256_srli_epi32(x, 24);
+}
+
+GV_AVX2 __m256i PackI8::avx2(__m256i x) noexcept {
+    __m256i mask = _mm256_set1_epi32(0x00ff00ff);
+    __m256i rb = _mm256_and_si256(x, mask);
+    __m256i ga = _mm256_and_si256(_mm256_srli_epi32(x, 8), mask);
+    __m256i sum = _mm256_add_epi32(
+        _mm256_madd_epi16(rb, _mm256_set1_epi32((LUM_B << 16) | LUM_R)),
+        _mm256_madd_epi16(ga, _mm256_set1_epi32(LUM_G)));
+    return _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(128)), 8);
+}
+
+GV_AVX2 __m256i PackAI88::avx2(__m256i x) noexcept {
+    __m256i a = _mm256_slli_epi32(_mm256_srli_epi32(x, 24), 8);
+    return _mm256_or_si256(PackI8::avx2(x), a);
+}
+
+/* the packs work within the 128 bits lanes, the results are put
+ * back in order by a permute */
+template <typename _Pack>
+static GV_AVX2 void avx2Pack16(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m256i x0 = _Pack::avx2(_mm256_loadu_si256((const __m256i*)(s + i * 4)));
+        __m256i x1 = _Pack::avx2(_mm256_loadu_si256((const __m256i*)(s + i * 4 + 32)));
+        x0 = _mm256_srai_epi32(_mm256_slli_epi32(x0, 16), 16);
+        x1 = _mm256_srai_epi32(_mm256_slli_epi32(x1, 16), 16);
+        __m256i v = _mm256_permute4x64_epi64(_mm256_packs_epi32(x0, x1), 0xd8);
+        _mm256_storeu_si256((__m256i*)(d + i * 2), v);
+    }
+    sse2Pack16<_Pack>(s + i * 4, d + i * 2, n - i);
+}
+
+template <typename _Pack>
+static GV_AVX2 void avx2Pack8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    for (; i + 32 <= n; i += 32) {
+        const __m256i *p = (const __m256i*)(s + i * 4);
+        __m256i lo = _mm256_packs_epi32(_Pack::avx2(_mm256_loadu_si256(p)), _Pack::avx2(_mm256_loadu_si256(p + 1)));
+        __m256i hi = _mm256_packs_epi32(_Pack::avx2(_mm256_loadu_si256(p + 2)), _Pack::avx2(_mm256_loadu_si256(p + 3)));
+        __m256i v = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(lo, hi), order);
+        _mm256_storeu_si256((__m256i*)(d + i), v);
+    }
+    sse2Pack8<_Pack>(s + i * 4, d + i, n - i);
+}
+
+/* 4 pixels a lane, the stores overlap by 4 bytes and the loop keeps
+ * them inside the destination */
+static GV_AVX2 void avx2PackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+        0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    for (; i + 10 <= n; i += 8) {
+        __m256i v = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)(s + i * 4)), shuffle);
+        _mm_storeu_si128((__m128i*)(d + i * 3), _mm256_castsi256_si128(v));
+        _mm_storeu_si128((__m128i*)(d + i * 3 + 12), _mm256_extracti128_si256(v, 1));
+    }
+    scalarPackRGB888(s + i * 4, d + i * 3, n - i);
+}
+
+static GV_AVX2 void avx2UnpackI8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+    for (; i + 8 <= n; i += 8) {
+        __m256i l = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*)(s + i)));
+        __m256i v = _mm256_or_si256(_mm256_or_si256(l, _mm256_slli_epi32(l, 8)), _mm256_or_si256(_mm256_slli_epi32(l, 16), alpha));
+        _mm256_storeu_si256((__m256i*)(d + i * 4), v);
+    }
+    sse2UnpackI8(s + i, d + i * 4, n - i);
+}
+
+static GV_AVX2 void avx2UnpackAI88(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+    for (; i + 8 <= n; i += 8) {
+        __m256i la = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(s + i * 2)));
+        __m256i l = _mm256_and_si256(la, _mm256_set1_epi32(0xff));
+        __m256i a = _mm256_and_si256(_mm256_slli_epi32(la, 16), alpha);
+        __m256i v = _mm256_or_si256(_mm256_or_si256(l, _mm256_slli_epi32(l, 8)), _mm256_or_si256(_mm256_slli_epi32(l, 16), a));
+        _mm256_storeu_si256((__m256i*)(d + i * 4), v);
+    }
+    sse2UnpackAI88(s + i * 2, d + i * 4, n - i);
+}
+
+static GV_AVX2 void avx2UnpackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    __m256i shuffle = _mm256_setr_epi8(
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+    for (; i + 10 <= n; i += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(s + i * 3));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(s + i * 3 + 12));
+        __m256i v = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        v = _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha);
+        _mm256_storeu_si256((__m256i*)(d + i * 4), v);
+    }
+    scalarUnpackRGB888(s + i * 3, d + i * 4, n - i);
+}
+
+static inline GV_AVX2 __m256i avx2Distance(__m256i a, __m256i b) noexcept {
+    return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+}
+
+template <int __shift>
+static inline GV_AVX2 __m256i avx2Quantize(__m256i x) noexcept {
+    __m256i q = _mm256_and_si256(x, _mm256_set1_epi8((char)(0xff << __shift)));
+    __m256i low = _mm256_and_si256(_mm256_srli_epi16(q, 8 - __shift), _mm256_set1_epi8((char)(0xff >> (8 - __shift))));
+    return avx2Distance(x, _mm256_or_si256(q, low));
+}
+
+static GV_AVX2 void avx2Scan(const unsigned char *s, size_t n, PixelStats &stats) {
+    size_t i = 0;
+    __m256i alpha = _mm256_set1_epi8((char)0xff);
+    __m256i alpha1 = _mm256_setzero_si256();
+    __m256i gray = _mm256_setzero_si256();
+    __m256i max5 = _mm256_setzero_si256();
+    __m256i max6 = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + i * 4));
+        alpha = _mm256_min_epu8(alpha, x);
+        alpha1 = _mm256_max_epu8(alpha1, _mm256_min_epu8(x, _mm256_xor_si256(x, _mm256_set1_epi8((char)0xff))));
+        gray = _mm256_max_epu8(gray, avx2Distance(x, _mm256_srli_epi32(x, 8)));
+        max5 = _mm256_max_epu8(max5, avx2Quantize<3>(x));
+        max6 = _mm256_max_epu8(max6, avx2Quantize<2>(x));
+    }
+    unsigned char bytes[5][32];
+    _mm256_storeu_si256((__m256i*)bytes[0], alpha);
+    _mm256_storeu_si256((__m256i*)bytes[1], alpha1);
+    _mm256_storeu_si256((__m256i*)bytes[2], gray);
+    _mm256_storeu_si256((__m256i*)bytes[3], max5);
+    _mm256_storeu_si256((__m256i*)bytes[4], max6);
+    mergeScan(bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], 32, stats);
+    sse2Scan(s + i * 4, n - i, stats);
+}
+
+static GV_AVX2 void avx2Ordered(unsigned char *p, size_t n, const unsigned char *table) {
+    size_t i = 0;
+    __m256i threshold = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table));
+    __m256i mask4 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(table + 16)));
+    __m256i mask5 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(table + 32)));
+    __m256i mask6 = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)(table + 48)));
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i * 4));
+        __m256i low = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(x, 4), mask4),
+            _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(x, 5), mask5), _mm256_and_si256(_mm256_srli_epi16(x, 6), mask6)));
+        _mm256_storeu_si256((__m256i*)(p + i * 4), _mm256_adds_epu8(_mm256_sub_epi8(x, low), threshold));
+    }
+    sse2Ordered(p + i * 4, n - i, table);
+}
+
+static inline GV_AVX2 __m256i avx2Mul255(__m256i x, __m256i a) noexcept {
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, a), _mm256_set1_epi16(128));
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+static inline GV_AVX2 __m256i avx2Alpha(__m256i x, __m256i opaque) noexcept {
+    return _mm256_or_si256(_mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xff), 0xff), opaque);
+}
+
+/* the unpacks and the pack work within the 128 bits halves, the
+ * pixels come back in order */
+static GV_AVX2 void avx2Premultiply(unsigned char *p, size_t n) {
+    size_t i = 0;
+    __m256i zero = _mm256_setzero_si256();
+    __m256i opaque = _mm256_set_epi16(0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0, 0xff, 0, 0, 0);
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(p + i * 4));
+        __m256i lo = _mm256_unpacklo_epi8(x, zero);
+        __m256i hi = _mm256_unpackhi_epi8(x, zero);
+        lo = avx2Mul255(lo, avx2Alpha(lo, opaque));
+        hi = avx2Mul255(hi, avx2Alpha(hi, opaque));
+        _mm256_storeu_si256((__m256i*)(p + i * 4), _mm256_packus_epi16(lo, hi));
+    }
+    sse2Premultiply(p + i * 4, n - i);
+}
+
+static const PixelKernels __avx2Kernels = {
+    PixelIsa::AVX2, "avx2",
+    {
+        nullptr,
+        avx2UnpackI8,
+        avx2UnpackAI88,
+        avx2UnpackRGB888,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+    },
+    {
+        avx2Pack8<PackA8>,
+        avx2Pack8<PackI8>,
+        avx2Pack16<PackAI88>,
+        avx2PackRGB888,
+        nullptr,
+        avx2Pack16<PackRGB565>,
+        avx2Pack16<PackRGBA4444>,
+        avx2Pack16<PackRGBA5551>,
+    },
+    avx2Scan,
+    avx2Ordered,
+    avx2Premultiply,
+};
+
+static bool cpuSupports(PixelIsa isa) noexcept {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    if (isa == PixelIsa::SSE2) {
+        return (info[3] & (1 << 26)) != 0;
+    }
+    // the os must save the ymm registers too
+    if (!(info[2] & (1 << 27)) || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    if (isa == PixelIsa::SSE2) {
+        return __builtin_cpu_supports("sse2");
+    }
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if GV_PIXEL_NEON
+/* NEON, 16 pixels a step, deinterleaved by the structure loads */
+static inline uint8x16_t neonLuminance(const uint8x16x4_t &x) noexcept {
+    uint16x8_t lo = vmull_u8(vget_low_u8(x.val[0]), vdup_n_u8(LUM_R));
+    lo = vmlal_u8(lo, vget_low_u8(x.val[1]), vdup_n_u8(LUM_G));
+    lo = vmlal_u8(lo, vget_low_u8(x.val[2]), vdup_n_u8(LUM_B));
+    uint16x8_t hi = vmull_u8(vget_high_u8(x.val[0]), vdup_n_u8(LUM_R));
+    hi = vmlal_u8(hi, vget_high_u8(x.val[1]), vdup_n_u8(LUM_G));
+    hi = vmlal_u8(hi, vget_high_u8(x.val[2]), vdup_n_u8(LUM_B));
+    return vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+}
+
+/* the channels are moved to the top byte, then shifted right and
+ * inserted below the ones already placed, no alpha if __a is 0 (the
+ * shift must be valid even in the branch not taken) */
+template <int __g, int __b, int __a>
+static inline uint16x8_t neonPack(uint8x8_t r, uint8x8_t g, uint8x8_t b, uint8x8_t a) noexcept {
+    uint16x8_t v = vshll_n_u8(r, 8);
+    v = vsriq_n_u16(v, vshll_n_u8(g, 8), __g);
+    v = vsriq_n_u16(v, vshll_n_u8(b, 8), __b);
+    if (__a) {
+        v = vsriq_n_u16(v, vshll_n_u8(a, 8), __a ? __a : 1);
+    }
+    return v;
+}
+
+template <int __g, int __b, int __a>
+static void neonPackShort(const unsigned char *s, unsigned char *d, size_t n, void (*tail)(const unsigned char*, unsigned char*, size_t)) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t x = vld4q_u8(s + i * 4);
+        uint16x8_t lo = neonPack<__g, __b, __a>(vget_low_u8(x.val[0]), vget_low_u8(x.val[1]), vget_low_u8(x.val[2]), vget_low_u8(x.val[3]));
+        uint16x8_t hi = neonPack<__g, __b, __a>(vget_high_u8(x.val[0]), vget_high_u8(x.val[1]), vget_high_u8(x.val[2]), vget_high_u8(x.val[3]));
+        vst1q_u8(d + i * 2, vreinterpretq_u8_u16(lo));
+        vst1q_u8(d + i * 2 + 16, vreinterpretq_u8_u16(hi));
+    }
+    tail(s + i * 4, d + i * 2, n - i);
+}
+
+static void neonPackRGB565(const unsigned char *s, unsigned char *d, size_t n) {
+    neonPackShort<5, 11, 0>(s, d, n, scalarPack16<PackRGB565>);
+}
+
+static void neonPackRGBA4444(const unsigned char *s, unsigned char *d, size_t n) {
+    neonPackShort<4, 8, 12>(s, d, n, scalarPack16<PackRGBA4444>);
+}
+
+static void neonPackRGBA5551(const unsigned char *s, unsigned char *d, size_t n) {
+    neonPackShort<5, 10, 15>(s, d, n, scalarPack16<PackRGBA5551>);
+}
+
+static void neonPackA8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        vst1q_u8(d + i, vld4q_u8(s + i * 4).val[3]);
+    }
+    scalarPack8<PackA8>(s + i * 4, d + i, n - i);
+}
+
+static void neonPackI8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        vst1q_u8(d + i, neonLuminance(vld4q_u8(s + i * 4)));
+    }
+    scalarPack8<PackI8>(s + i * 4, d + i, n - i);
+}
+
+static void neonPackAI88(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t x = vld4q_u8(s + i * 4);
+        uint8x16x2_t v;
+        v.val[0] = neonLuminance(x);
+        v.val[1] = x.val[3];
+        vst2q_u8(d + i * 2, v);
+    }
+    scalarPack16<PackAI88>(s + i * 4, d + i * 2, n - i);
+}
+
+static void neonPackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t x = vld4q_u8(s + i * 4);
+        uint8x16x3_t v;
+        v.val[0] = x.val[0];
+        v.val[1] = x.val[1];
+        v.val[2] = x.val[2];
+        vst3q_u8(d + i * 3, v);
+    }
+    scalarPackRGB888(s + i * 4, d + i * 3, n - i);
+}
+
+static void neonUnpackI8(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t v;
+        v.val[0] = v.val[1] = v.val[2] = vld1q_u8(s + i);
+        v.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(d + i * 4, v);
+    }
+    scalarUnpackI8(s + i, d + i * 4, n - i);
+}
+
+static void neonUnpackAI88(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x2_t x = vld2q_u8(s + i * 2);
+        uint8x16x4_t v;
+        v.val[0] = v.val[1] = v.val[2] = x.val[0];
+        v.val[3] = x.val[1];
+        vst4q_u8(d + i * 4, v);
+    }
+    scalarUnpackAI88(s + i * 2, d + i * 4, n - i);
+}
+
+static void neonUnpackRGB888(const unsigned char *s, unsigned char *d, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x3_t x = vld3q_u8(s + i * 3);
+        uint8x16x4_t v;
+        v.val[0] = x.val[0];
+        v.val[1] = x.val[1];
+        v.val[2] = x.val[2];
+        v.val[3] = vdupq_n_u8(0xff);
+        vst4q_u8(d + i * 4, v);
+    }
+    scalarUnpackRGB888(s + i * 3, d + i * 4, n - i);
+}
+
+template <int __shift>
+static inline uint8x16_t neonQuantize(uint8x16_t x) noexcept {
+    uint8x16_t q = vandq_u8(x, vdupq_n_u8((unsigned char)(0xff << __shift)));
+    return vabdq_u8(x, vorrq_u8(q, vshrq_n_u8(q, 8 - __shift)));
+}
+
+static void neonScan(const unsigned char *s, size_t n, PixelStats &stats) {
+    size_t i = 0;
+    uint8x16_t alpha = vdupq_n_u8(0xff);
+    uint8x16_t alpha1 = vdupq_n_u8(0);
+    uint8x16_t gray = vdupq_n_u8(0);
+    uint8x16_t rb5 = vdupq_n_u8(0);
+    uint8x16_t g5 = vdupq_n_u8(0);
+    uint8x16_t g6 = vdupq_n_u8(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t x = vld4q_u8(s + i * 4);
+        alpha = vminq_u8(alpha, x.val[3]);
+        alpha1 = vmaxq_u8(alpha1, vminq_u8(x.val[3], vmvnq_u8(x.val[3])));
+        gray = vmaxq_u8(gray, vmaxq_u8(vabdq_u8(x.val[0], x.val[1]), vabdq_u8(x.val[1], x.val[2])));
+        rb5 = vmaxq_u8(rb5, vmaxq_u8(neonQuantize<3>(x.val[0]), neonQuantize<3>(x.val[2])));
+        g5 = vmaxq_u8(g5, neonQuantize<3>(x.val[1]));
+        g6 = vmaxq_u8(g6, neonQuantize<2>(x.val[1]));
+    }
+    // vminvq and vmaxvq are aarch64 only
+    unsigned char bytes[6][16];
+    vst1q_u8(bytes[0], alpha);
+    vst1q_u8(bytes[1], alpha1);
+    vst1q_u8(bytes[2], gray);
+    vst1q_u8(bytes[3], rb5);
+    vst1q_u8(bytes[4], g5);
+    vst1q_u8(bytes[5], g6);
+    for (int k = 0; k < 16; ++k) {
+        stats.alpha = std::min(stats.alpha, bytes[0][k]);
+        stats.alpha1 = std::max(stats.alpha1, bytes[1][k]);
+        stats.gray = std::max(stats.gray, bytes[2][k]);
+        stats.rb5 = std::max(stats.rb5, bytes[3][k]);
+        stats.g5 = std::max(stats.g5, bytes[4][k]);
+        stats.g6 = std::max(stats.g6, bytes[5][k]);
+    }
+    scalarScan(s + i * 4, n - i, stats);
+}
+
+static void neonOrdered(unsigned char *p, size_t n, const unsigned char *table) {
+    size_t i = 0;
+    uint8x16_t threshold = vld1q_u8(table);
+    uint8x16_t mask4 = vld1q_u8(table + 16);
+    uint8x16_t mask5 = vld1q_u8(table + 32);
+    uint8x16_t mask6 = vld1q_u8(table + 48);
+    for (; i + 4 <= n; i += 4) {
+        uint8x16_t x = vld1q_u8(p + i * 4);
+        uint8x16_t low = vorrq_u8(vandq_u8(vshrq_n_u8(x, 4), mask4),
+            vorrq_u8(vandq_u8(vshrq_n_u8(x, 5), mask5), vandq_u8(vshrq_n_u8(x, 6), mask6)));
+        vst1q_u8(p + i * 4, vqaddq_u8(vsubq_u8(x, low), threshold));
+    }
+    scalarOrdered(p + i * 4, n - i, table);
+}
+
+/* mul255() of the products, widened */
+static inline uint8x8_t neonMul255(uint8x8_t c, uint8x8_t a) noexcept {
+    uint16x8_t t = vmull_u8(c, a);
+    return vrshrn_n_u16(vrsraq_n_u16(t, t, 8), 8);
+}
+
+static void neonPremultiply(unsigned char *p, size_t n) {
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16x4_t x = vld4q_u8(p + i * 4);
+        for (int c = 0; c < 3; ++c) {
+            x.val[c] = vcombine_u8(neonMul255(vget_low_u8(x.val[c]), vget_low_u8(x.val[3])),
+                                   neonMul255(vget_high_u8(x.val[c]), vget_high_u8(x.val[3])));
+        }
+        vst4q_u8(p + i * 4, x);
+    }
+    scalarPremultiply(p + i * 4, n - i);
+}
+
+static const PixelKernels __neonKernels = {
+    PixelIsa::NEON, "neon",
+    {
+        nullptr,
+        neonUnpackI8,
+        neonUnpackAI88,
+        neonUnpackRGB888,
+        nullptr,
+        nullptr,
+        nullptr,
+        nullptr,
+    },
+    {
+        neonPackA8,
+        neonPackI8,
+        neonPackAI88,
+        neonPackRGB888,
+        nullptr,
+        neonPackRGB565,
+        neonPackRGBA4444,
+        neonPackRGBA5551,
+    },
+    neonScan,
+    neonOrdered,
+    neonPremultiply,
+};
+#endif
+
+const PixelKernels *pixelKernels(PixelIsa isa) noexcept {
+    switch (isa) {
+    case PixelIsa::SCALAR:
+        return &__scalarKernels;
+#if GV_PIXEL_X86
+    case PixelIsa::SSE2:
+        return cpuSupports(PixelIsa::SSE2) ? &__sse2Kernels : nullptr;
+    case PixelIsa::AVX2:
+        return cpuSupports(PixelIsa::AVX2) ? &__avx2Kernels : nullptr;
+#endif
+#if GV_PIXEL_NEON
+    case PixelIsa::NEON:
+        return &__neonKernels;
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const PixelKernels &pixelKernels() noexcept {
+    static const PixelKernels *kernels = []() {
+        const PixelKernels *best = nullptr;
+        for (PixelIsa isa : {PixelIsa::AVX2, PixelIsa::NEON, PixelIsa::SSE2}) {
+            if ((best = pixelKernels(isa))) {
+                break;
+            }
+        }
+        return best ? best : &__scalarKernels;
+    }();
+    return *kernels;
+}
+
+GV_NS_END
+
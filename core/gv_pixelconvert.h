@@ -0,0 +1,77 @@
+#ifndef __GV_PIXEL_CONVERT_H__
+#define __GV_PIXEL_CONVERT_H__
+
+#include <cstddef>
+
+#include "gv_pixel.h"
+
+GV_NS_BEGIN
+
+enum class PixelIsa {
+    SCALAR,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+/* converts count pixels, src and dst don't overlap */
+typedef void (*PixelKernel)(const unsigned char *src, unsigned char *dst, size_t count);
+
+/**
+ * @brief What a scan found in RGBA8888 pixels. The errors are the
+ *        largest ones of a channel converted to fewer bits and back.
+ */
+struct PixelStats {
+    unsigned char alpha;    /* the lowest alpha */
+    unsigned char alpha1;   /* of alpha to 1 bit */
+    unsigned char gray;     /* the largest difference between r, g and b */
+    unsigned char rb5;      /* of r and b to 5 bits */
+    unsigned char g5;
+    unsigned char g6;
+};
+
+/* merges count pixels into stats, which starts as PixelStats{255} */
+typedef void (*PixelScan)(const unsigned char *src, size_t count, PixelStats &stats);
+
+/* adds a threshold to each channel of count RGBA8888 pixels in place,
+ * so that the truncating packers round them by a pattern. The table
+ * holds 4 pixels: 16 bytes of thresholds, then the masks of the bits
+ * left by shifting right 4, 5 and 6, which are taken off first */
+typedef void (*PixelOrdered)(unsigned char *pixels, size_t count, const unsigned char *table);
+
+/* multiplies the colors of count RGBA8888 pixels by their alpha in
+ * place, rounded to the nearest */
+typedef void (*PixelPremultiply)(unsigned char *pixels, size_t count);
+
+/**
+ * @brief The conversion kernels of an instruction set. A conversion
+ *        goes through RGBA8888: the source is unpacked to it, then
+ *        packed into the destination format.
+ */
+struct PixelKernels {
+    PixelIsa         isa;
+    const char      *name;
+    /* to RGBA8888, indexed by the source format, nullptr if none */
+    PixelKernel      unpack[static_cast<size_t>(PixelFormat::UNKNOWN)];
+    /* from RGBA8888, indexed by the destination format */
+    PixelKernel      pack[static_cast<size_t>(PixelFormat::UNKNOWN)];
+    PixelScan        scan;
+    PixelOrdered     ordered;
+    PixelPremultiply premultiply;
+};
+
+/**
+ * @brief The kernels of isa, nullptr if the cpu lacks it or the build
+ *        doesn't target it.
+ */
+const PixelKernels *pixelKernels(PixelIsa isa) noexcept;
+/**
+ * @brief The kernels of the best instruction set of the cpu, chosen
+ *        on the first call.
+ */
+const PixelKernels &pixelKernels() noexcept;
+
+GV_NS_END
+
+#endif
+
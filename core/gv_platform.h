@@ -61,6 +61,14 @@ static void *operator new[](std::size_t size) {            \
 #endif
 #endif
 
+#if defined(_MSC_VER)
+#define GV_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+#define GV_THREAD_LOCAL __thread
+#else
+#define GV_THREAD_LOCAL thread_local
+#endif
+
 #if defined(__GNUC__)
 #define GV_UNUSED(x) x __attribute__((unused))
 #else
@@ -0,0 +1,129 @@
+#include "opengxv.h"
+#include "gv_ranktree.h"
+#include "gv_log.h"
+
+GV_NS_BEGIN
+
+static inline unsigned node_size(const ranktree::node *n) noexcept {
+    return n ? n->_size : 0;
+}
+
+static inline void update(ranktree::node *n) noexcept {
+    n->_size = node_size(n->_left) + node_size(n->_right) + 1;
+    if (n->_left) {
+        n->_left->_parent = n;
+    }
+    if (n->_right) {
+        n->_right->_parent = n;
+    }
+}
+
+/* the priorities only need to look random, the node address is mixed
+ * so that the tree stays balanced whatever the insertion order */
+static inline unsigned priority(const ranktree::node *n) noexcept {
+    uint64_t x = (uint64_t)(uintptr_t)n;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return (unsigned)x;
+}
+
+void ranktree::split(node *t, unsigned index, node *&left, node *&right) noexcept {
+    if (!t) {
+        left = right = nullptr;
+        return;
+    }
+    unsigned n = node_size(t->_left);
+    if (index <= n) {
+        split(t->_left, index, left, t->_left);
+        right = t;
+    }
+    else {
+        split(t->_right, index - n - 1, t->_right, right);
+        left = t;
+    }
+    update(t);
+}
+
+ranktree::node *ranktree::merge(node *left, node *right) noexcept {
+    if (!left) {
+        return right;
+    }
+    if (!right) {
+        return left;
+    }
+    if (left->_priority > right->_priority) {
+        left->_right = merge(left->_right, right);
+        update(left);
+        return left;
+    }
+    right->_left = merge(left, right->_left);
+    update(right);
+    return right;
+}
+
+ranktree::node *ranktree::at(unsigned index) const noexcept {
+    node *n = _root;
+    while (n) {
+        unsigned left = node_size(n->_left);
+        if (index < left) {
+            n = n->_left;
+        }
+        else if (index == left) {
+            break;
+        }
+        else {
+            index -= left + 1;
+            n = n->_right;
+        }
+    }
+    return n;
+}
+
+unsigned ranktree::index(const node *n) const noexcept {
+    unsigned index = node_size(n->_left);
+    for (const node *parent; (parent = n->_parent); n = parent) {
+        if (parent->_right == n) {
+            index += node_size(parent->_left) + 1;
+        }
+    }
+    return index;
+}
+
+void ranktree::insert(node *n, unsigned index) noexcept {
+    gv_assert(index <= size(), "index out of range.");
+    n->_left = n->_right = nullptr;
+    n->_size = 1;
+    n->_priority = priority(n);
+
+    node *left, *right;
+    split(_root, index, left, right);
+    _root = merge(merge(left, n), right);
+    _root->_parent = nullptr;
+}
+
+void ranktree::remove(node *n) noexcept {
+    node *parent = n->_parent;
+    node *child = merge(n->_left, n->_right);
+    if (child) {
+        child->_parent = parent;
+    }
+    if (!parent) {
+        _root = child;
+        return;
+    }
+    if (parent->_left == n) {
+        parent->_left = child;
+    }
+    else {
+        parent->_right = child;
+    }
+    for (; parent; parent = parent->_parent) {
+        --parent->_size;
+    }
+}
+
+GV_NS_END
+
@@ -0,0 +1,61 @@
+#ifndef __GV_RANKTREE_H__
+#define __GV_RANKTREE_H__
+
+#include "gv_platform.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief An intrusive sequence kept in a size-augmented treap: nodes
+ *        are ordered by position only, at() and index() are O(log n).
+ */
+class ranktree {
+public:
+    struct node {
+        node    *_parent;
+        node    *_left;
+        node    *_right;
+        unsigned _size;
+        unsigned _priority;
+    };
+
+    ranktree() noexcept : _root() {}
+
+    bool empty() const noexcept {
+        return !_root;
+    }
+
+    unsigned size() const noexcept {
+        return _root ? _root->_size : 0;
+    }
+
+    void clear() noexcept {
+        _root = nullptr;
+    }
+
+    /**
+     * @brief The node at position index, nullptr if out of range.
+     */
+    node *at(unsigned index) const noexcept;
+    /**
+     * @brief The position of n, which must be in the tree.
+     */
+    unsigned index(const node *n) const noexcept;
+
+    /**
+     * @brief Inserts n at position index, index <= size().
+     */
+    void insert(node *n, unsigned index) noexcept;
+    void remove(node *n) noexcept;
+
+private:
+    static void split(node *t, unsigned index, node *&left, node *&right) noexcept;
+    static node *merge(node *left, node *right) noexcept;
+
+    node *_root;
+};
+
+GV_NS_END
+
+#endif
+
@@ -1,10 +1,173 @@
+
 #include "opengxv.h"
+#include <algorithm>
 #include "gv_renderer.h"
 
 
 GV_NS_BEGIN
 
+Renderer::Renderer() noexcept
+: _width(),
+  _height(),
+  _drawCalls(),
+  _vertexCount(),
+  _flushes()
+{
+    _projection = new Matrix;
+    _projection->setIdentity();
+}
+
+void Renderer::viewport(unsigned width, unsigned height) noexcept {
+    _width = width;
+    _height = height;
+}
+
+void Renderer::projection(const Matrix &mat) noexcept {
+    flush();
+    *_projection = mat;
+}
+
+void Renderer::begin(unsigned color) noexcept {
+    _vertices.clear();
+    _batches.clear();
+    _drawCalls = 0;
+    _vertexCount = 0;
+    clear(color);
+}
+
+void Renderer::end() noexcept {
+    flush();
+    present();
+}
+
+void Renderer::flush() noexcept {
+    if (_batches.empty()) {
+        return;
+    }
+    draw(_vertices.data(), (unsigned)_vertices.size(), _batches.data(), (unsigned)_batches.size());
+    _drawCalls += (unsigned)_batches.size();
+    ++_flushes;
+    _vertices.clear();
+    _batches.clear();
+}
+
+inline Vertex *Renderer::alloc(unsigned count, Texture *texture, BlendMode blend) noexcept {
+    if (_vertices.size() + count > maxVertices) {
+        flush();
+    }
+    unsigned first = (unsigned)_vertices.size();
+    if (_batches.empty() || _batches.back().texture != texture || _batches.back().blend != blend) {
+        _batches.emplace_back(texture, blend, first);
+    }
+    _batches.back().count += count;
+    _vertexCount += count;
+    _vertices.resize(first + count);
+    return _vertices.data() + first;
+}
+
+static inline unsigned char mul8(unsigned a, unsigned b) noexcept {
+    return (unsigned char)((a * b + 127) / 255);
+}
+
+static inline void premultiply(Vertex &v) noexcept {
+    if (v.a != 0xff) {
+        v.r = mul8(v.r, v.a);
+        v.g = mul8(v.g, v.a);
+        v.b = mul8(v.b, v.a);
+    }
+}
+
+void Renderer::drawTriangles(const Vertex *vertices, unsigned count, Texture *texture, BlendMode blend) noexcept {
+    count -= count % 3;
+    if (!count) {
+        return;
+    }
+    Vertex *d = alloc(count, texture, blend);
+    memcpy(d, vertices, sizeof(Vertex) * count);
+    if (!texture || texture->pmAlpha()) {
+        for (Vertex *end = d + count; d < end; ++d) {
+            premultiply(*d);
+        }
+    }
+}
+
+void Renderer::drawQuads(const Vertex *vertices, unsigned count, Texture *texture, BlendMode blend) noexcept {
+    count >>= 2;
+    if (!count) {
+        return;
+    }
+    Vertex *d = alloc(count * 6, texture, blend);
+    Vertex *first = d;
+    for (const Vertex *end = vertices + count * 4; vertices < end; vertices += 4) {
+        *d++ = vertices[0];
+        *d++ = vertices[1];
+        *d++ = vertices[2];
+        *d++ = vertices[0];
+        *d++ = vertices[2];
+        *d++ = vertices[3];
+    }
+    if (!texture || texture->pmAlpha()) {
+        for (; first < d; ++first) {
+            premultiply(*first);
+        }
+    }
+}
+
+bool Renderer::record(const Mark &from, RenderCache &cache) noexcept {
+    if (!cache._valid) {
+        return false;
+    }
+    if (from.flushes != _flushes) {
+        cache.invalidate();
+        return false;
+    }
+    unsigned end = (unsigned)_vertices.size();
+    if (from.offset >= end) {
+        return true;
+    }
+
+    // batches are contiguous, find the first one reaching into the range
+    auto batch = _batches.end();
+    while (batch != _batches.begin() && (batch - 1)->first + (batch - 1)->count > from.offset) {
+        --batch;
+    }
+    unsigned base = (unsigned)cache._vertices.size();
+    for (; batch != _batches.end(); ++batch) {
+        unsigned first = std::max(batch->first, from.offset);
+        unsigned count = batch->first + batch->count - first;
+        auto &commands = cache._commands;
+        if (!commands.empty() && commands.back().texture == batch->texture && commands.back().blend == batch->blend) {
+            commands.back().count += count;
+        }
+        else {
+            commands.emplace_back(batch->texture, batch->blend, base + first - from.offset, count);
+        }
+    }
+    cache._vertices.insert(cache._vertices.end(), _vertices.begin() + from.offset, _vertices.end());
+    return true;
+}
 
+void Renderer::replay(const RenderCache &cache, unsigned first, unsigned count) noexcept {
+    unsigned end = first + count;
+    auto &commands = cache._commands;
+    auto command = std::upper_bound(commands.begin(), commands.end(), first, 
+        [](unsigned offset, const RenderCache::Command &cmd) {
+            return offset < cmd.first;
+        });
+    if (command != commands.begin()) {
+        --command;
+    }
+    for (; command != commands.end() && command->first < end; ++command) {
+        unsigned from = std::max(command->first, first);
+        unsigned n = std::min(command->first + command->count, end) - from;
+        if (n) {
+            memcpy(alloc(n, command->texture, command->blend), cache._vertices.data() + from, sizeof(Vertex) * n);
+        }
+    }
+}
 
+ptr<Chunk> Renderer::readPixels() noexcept {
+    return nullptr;
+}
 
 GV_NS_END
@@ -1,16 +1,213 @@
 #ifndef __GV_RENDERER_H__
 #define __GV_RENDERER_H__
 
+#include <vector>
+
 #include "gv_object.h"
+#include "gv_math.h"
+#include "gv_chunk.h"
+#include "gv_texture.h"
 
 GV_NS_BEGIN
 
+struct Vertex {
+    float x, y, z;
+    float u, v;
+    unsigned char r, g, b, a;
+
+    Vertex() noexcept : x(), y(), z(), u(), v(), r(), g(), b(), a() {}
+    Vertex(const Vec3f &pos, unsigned color, float s = 0.f, float t = 0.f) noexcept
+    : x(pos.x()), y(pos.y()), z(pos.z()),
+      u(s), v(t),
+      r((unsigned char)(color >> 16)),
+      g((unsigned char)(color >> 8)),
+      b((unsigned char)color),
+      a((unsigned char)(color >> 24)) {}
+};
+
+enum class BlendMode {
+    NORMAL,
+    ADD,
+    MULTIPLY,
+    SCREEN,
+};
+
+/**
+ * @brief A retained copy of a range of the vertex stream, with the
+ *        texture and blend state of each part of it, that can be
+ *        replayed into a later frame without traversing the display
+ *        objects that produced it.
+ */
+class RenderCache {
+    friend class Renderer;
+public:
+    RenderCache() noexcept : _valid(false) {}
+
+    bool valid() const noexcept {
+        return _valid;
+    }
+    unsigned size() const noexcept {
+        return (unsigned)_vertices.size();
+    }
+    void clear() noexcept {
+        _vertices.clear();
+        _commands.clear();
+        _valid = true;
+    }
+    void invalidate() noexcept {
+        _vertices.clear();
+        _commands.clear();
+        _valid = false;
+    }
+    void swap(RenderCache &x) noexcept {
+        _vertices.swap(x._vertices);
+        _commands.swap(x._commands);
+        std::swap(_valid, x._valid);
+    }
+
+private:
+    struct Command {
+        Command(Texture *tex, BlendMode mode, unsigned start, unsigned n) noexcept
+        : texture(tex), blend(mode), first(start), count(n) {}
+
+        ptr<Texture> texture;
+        BlendMode    blend;
+        unsigned     first;
+        unsigned     count;
+    };
+    std::vector<Vertex>  _vertices;
+    std::vector<Command> _commands;
+    bool                 _valid;
+};
+
+/**
+ * @brief The Renderer class is the backend the display list
+ *        draws into. DisplayObject::draw() emits already
+ *        transformed triangles; the backend owns the target
+ *        surface (a GL context, a CPU framebuffer, ...).
+ *
+ * A frame is begin(), any number of drawTriangles() or
+ * drawQuads(), end(). Draws are appended to a single vertex
+ * stream, consecutive draws sharing the texture and blend mode
+ * are merged into one batch, and the batches are handed to the
+ * backend on flush(), at the latest by end().
+ *
+ * Vertex colors are given straight. Those drawn untextured or with
+ * a premultiplied texture are premultiplied into the stream, so that
+ * these batches share the premultiplied blend state of their mode.
+ */
 class Renderer : public Object {
     friend class Object;
 public:
+    static constexpr unsigned maxVertices = 65536;
+
+    unsigned width() const noexcept {
+        return _width;
+    }
+    unsigned height() const noexcept {
+        return _height;
+    }
+    const Matrix &projection() const noexcept {
+        return *_projection;
+    }
+
+    /**
+     * @brief Draw calls issued to the backend since begin().
+     */
+    unsigned drawCalls() const noexcept {
+        return _drawCalls;
+    }
+    /**
+     * @brief Vertices submitted since begin().
+     */
+    unsigned vertexCount() const noexcept {
+        return _vertexCount;
+    }
+
+    virtual void viewport(unsigned width, unsigned height) noexcept;
+    virtual void projection(const Matrix &mat) noexcept;
+
+    /**
+     * @brief Starts a frame and clears the target with color
+     *        (0xAARRGGBB).
+     */
+    void begin(unsigned color) noexcept;
+    void end() noexcept;
+    void flush() noexcept;
+
+    void drawTriangles(const Vertex *vertices, unsigned count, Texture *texture = nullptr, BlendMode blend = BlendMode::NORMAL) noexcept;
+    /**
+     * @brief Draws count / 4 quads, each given as four corners in
+     *        fan order.
+     */
+    void drawQuads(const Vertex *vertices, unsigned count, Texture *texture = nullptr, BlendMode blend = BlendMode::NORMAL) noexcept;
+
+    /**
+     * @brief A position in the vertex stream, taken by mark() before
+     *        drawing something that should be recorded.
+     */
+    struct Mark {
+        unsigned flushes;
+        unsigned offset;
+    };
+    Mark mark() const noexcept {
+        Mark m = { _flushes, (unsigned)_vertices.size() };
+        return m;
+    }
+    /**
+     * @brief Appends everything drawn since from to cache. Fails and
+     *        invalidates cache if the stream was flushed meanwhile.
+     */
+    bool record(const Mark &from, RenderCache &cache) noexcept;
+    /**
+     * @brief Draws count vertices of cache starting at first.
+     */
+    void replay(const RenderCache &cache, unsigned first, unsigned count) noexcept;
+    void replay(const RenderCache &cache) noexcept {
+        replay(cache, 0, cache.size());
+    }
+
+    /**
+     * @brief Reads back the last rendered frame as RGBA8888, top
+     *        row first. Returns nullptr if the backend can't.
+     */
+    virtual ptr<Chunk> readPixels() noexcept;
+
+protected:
+    struct Batch {
+        Batch(Texture *tex, BlendMode mode, unsigned start) noexcept
+        : texture(tex), blend(mode), first(start), count() {}
+
+        /* whether the colors of the batch are premultiplied */
+        bool pmAlpha() const noexcept {
+            return !texture || texture->pmAlpha();
+        }
+
+        ptr<Texture> texture;
+        BlendMode    blend;
+        unsigned     first;
+        unsigned     count;
+    };
+
+    Renderer() noexcept;
+    Vertex *alloc(unsigned count, Texture *texture, BlendMode blend) noexcept;
+
+    virtual void clear(unsigned color) noexcept = 0;
+    virtual void draw(const Vertex *vertices, unsigned count, const Batch *batches, unsigned batchCount) noexcept = 0;
+    virtual void present() noexcept {}
+
+    unsigned            _width;
+    unsigned            _height;
+    owned_ptr<Matrix>   _projection;
+    std::vector<Vertex> _vertices;
+    std::vector<Batch>  _batches;
+    unsigned            _drawCalls;
+    unsigned            _vertexCount;
+    unsigned            _flushes;
 };
 
 GV_NS_END
 
 #endif
 
+
@@ -0,0 +1,167 @@
+#include "opengxv.h"
+
+#include <cmath>
+#include "gv_softrenderer.h"
+
+GV_NS_BEGIN
+
+void SoftRenderer::viewport(unsigned width, unsigned height) noexcept {
+    if (!_framebuffer || width != _width || height != _height) {
+        _framebuffer = object<Chunk>((size_t)width * height * 4);
+    }
+    Renderer::viewport(width, height);
+}
+
+void SoftRenderer::clear(unsigned color) noexcept {
+    unsigned char pixel[4] = {
+        (unsigned char)(color >> 16),
+        (unsigned char)(color >> 8),
+        (unsigned char)color,
+        (unsigned char)(color >> 24),
+    };
+    if (!_framebuffer) {
+        return;
+    }
+    unsigned char *p = _framebuffer->data();
+    unsigned char *end = p + _framebuffer->size();
+    for (; p < end; p += 4) {
+        memcpy(p, pixel, 4);
+    }
+}
+
+ptr<Chunk> SoftRenderer::readPixels() noexcept {
+    if (!_framebuffer) {
+        return nullptr;
+    }
+    return object<Chunk>(_framebuffer->data(), _framebuffer->size());
+}
+
+inline bool SoftRenderer::project(const Vertex &vertex, point &p) const noexcept {
+    Eigen::Vector4f v = _projection->matrix() * Eigen::Vector4f(vertex.x, vertex.y, vertex.z, 1.f);
+    if (v.w() <= 0.f) {
+        return false;
+    }
+    p.x = (v.x() / v.w() + 1.f) * 0.5f * _width;
+    p.y = (1.f - v.y() / v.w()) * 0.5f * _height;
+    p.r = vertex.r;
+    p.g = vertex.g;
+    p.b = vertex.b;
+    p.a = vertex.a;
+    return true;
+}
+
+void SoftRenderer::draw(const Vertex *vertices, unsigned count, const Batch *batches, unsigned batchCount) noexcept {
+    if (!_framebuffer) {
+        return;
+    }
+    point p[3];
+    for (const Batch *batch = batches, *last = batches + batchCount; batch < last; ++batch) {
+        const Vertex *v = vertices + batch->first;
+        for (const Vertex *end = v + batch->count; v < end; v += 3) {
+            if (project(v[0], p[0]) && project(v[1], p[1]) && project(v[2], p[2])) {
+                rasterize(p[0], p[1], p[2], batch->blend, batch->pmAlpha());
+            }
+        }
+    }
+}
+
+static inline unsigned char mul8(unsigned a, unsigned b) noexcept {
+    return (unsigned char)((a * b + 127) / 255);
+}
+
+/* as GLRenderer::blend() sets the blend function */
+static inline void blendPixel(unsigned char *d, unsigned sr, unsigned sg, unsigned sb, unsigned sa, BlendMode blend, bool pmAlpha) noexcept {
+    unsigned ia = 255 - sa;
+    if (pmAlpha && (blend == BlendMode::NORMAL || blend == BlendMode::ADD)) {
+        unsigned id = blend == BlendMode::ADD ? 255 : ia;
+        d[0] = (unsigned char)std::min(sr + mul8(d[0], id), 255u);
+        d[1] = (unsigned char)std::min(sg + mul8(d[1], id), 255u);
+        d[2] = (unsigned char)std::min(sb + mul8(d[2], id), 255u);
+        d[3] = (unsigned char)std::min(sa + mul8(d[3], id), 255u);
+        return;
+    }
+    switch (blend) {
+    case BlendMode::ADD:
+        d[0] = (unsigned char)std::min(d[0] + mul8(sr, sa), 255);
+        d[1] = (unsigned char)std::min(d[1] + mul8(sg, sa), 255);
+        d[2] = (unsigned char)std::min(d[2] + mul8(sb, sa), 255);
+        d[3] = (unsigned char)std::min(d[3] + mul8(sa, sa), 255);
+        break;
+    case BlendMode::MULTIPLY:
+        d[0] = (unsigned char)std::min(mul8(sr, d[0]) + mul8(d[0], ia), 255);
+        d[1] = (unsigned char)std::min(mul8(sg, d[1]) + mul8(d[1], ia), 255);
+        d[2] = (unsigned char)std::min(mul8(sb, d[2]) + mul8(d[2], ia), 255);
+        d[3] = (unsigned char)std::min(mul8(sa, d[3]) + mul8(d[3], ia), 255);
+        break;
+    case BlendMode::SCREEN:
+        d[0] = (unsigned char)(sr + mul8(d[0], 255 - sr));
+        d[1] = (unsigned char)(sg + mul8(d[1], 255 - sg));
+        d[2] = (unsigned char)(sb + mul8(d[2], 255 - sb));
+        d[3] = (unsigned char)(sa + mul8(d[3], ia));
+        break;
+    default:
+        d[0] = (unsigned char)((sr * sa + d[0] * ia + 127) / 255);
+        d[1] = (unsigned char)((sg * sa + d[1] * ia + 127) / 255);
+        d[2] = (unsigned char)((sb * sa + d[2] * ia + 127) / 255);
+        d[3] = (unsigned char)(sa + mul8(d[3], ia));
+        break;
+    }
+}
+
+void SoftRenderer::rasterize(const point &p0, const point &p1, const point &p2, BlendMode blend, bool pmAlpha) noexcept {
+    float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+    if (area == 0.f) {
+        return;
+    }
+
+    int minx = std::max((int)std::floor(std::min(std::min(p0.x, p1.x), p2.x)), 0);
+    int miny = std::max((int)std::floor(std::min(std::min(p0.y, p1.y), p2.y)), 0);
+    int maxx = std::min((int)std::ceil(std::max(std::max(p0.x, p1.x), p2.x)), (int)_width - 1);
+    int maxy = std::min((int)std::ceil(std::max(std::max(p0.y, p1.y), p2.y)), (int)_height - 1);
+    if (minx > maxx || miny > maxy) {
+        return;
+    }
+
+    // edge functions e(x, y) = a * x + b * y + c, normalized so the 
+    // inside is positive whatever the winding.
+    float inv = 1.f / area;
+    float a0 = (p1.y - p2.y) * inv, b0 = (p2.x - p1.x) * inv;
+    float a1 = (p2.y - p0.y) * inv, b1 = (p0.x - p2.x) * inv;
+    float a2 = (p0.y - p1.y) * inv, b2 = (p1.x - p0.x) * inv;
+    float c0 = (p1.x * p2.y - p2.x * p1.y) * inv;
+    float c1 = (p2.x * p0.y - p0.x * p2.y) * inv;
+    float c2 = (p0.x * p1.y - p1.x * p0.y) * inv;
+
+    unsigned char *row = _framebuffer->data() + ((size_t)miny * _width + minx) * 4;
+    float fx = minx + 0.5f;
+    for (int y = miny; y <= maxy; ++y, row += _width * 4) {
+        float fy = y + 0.5f;
+        float w0 = a0 * fx + b0 * fy + c0;
+        float w1 = a1 * fx + b1 * fy + c1;
+        float w2 = a2 * fx + b2 * fy + c2;
+        unsigned char *d = row;
+        for (int x = minx; x <= maxx; ++x, d += 4, w0 += a0, w1 += a1, w2 += a2) {
+            if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+                continue;
+            }
+            unsigned sa = std::min((unsigned)(p0.a * w0 + p1.a * w1 + p2.a * w2 + 0.5f), 255u);
+            if (!sa) {
+                continue;
+            }
+            unsigned sr = std::min((unsigned)(p0.r * w0 + p1.r * w1 + p2.r * w2 + 0.5f), 255u);
+            unsigned sg = std::min((unsigned)(p0.g * w0 + p1.g * w1 + p2.g * w2 + 0.5f), 255u);
+            unsigned sb = std::min((unsigned)(p0.b * w0 + p1.b * w1 + p2.b * w2 + 0.5f), 255u);
+            if (sa == 255 && blend == BlendMode::NORMAL) {
+                d[0] = (unsigned char)sr;
+                d[1] = (unsigned char)sg;
+                d[2] = (unsigned char)sb;
+                d[3] = 255;
+                continue;
+            }
+            blendPixel(d, sr, sg, sb, sa, blend, pmAlpha);
+        }
+    }
+}
+
+GV_NS_END
+
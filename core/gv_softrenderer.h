@@ -0,0 +1,45 @@
+#ifndef __GV_SOFT_RENDERER_H__
+#define __GV_SOFT_RENDERER_H__
+
+#include "gv_renderer.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief A CPU rasterizer rendering into an RGBA8888 framebuffer, 
+ *        used by the headless stage. Triangles are filled with
+ *        the barycentrically interpolated vertex color and blended
+ *        by the batch blend mode, premultiplied or not; textures
+ *        are not sampled.
+ */
+class SoftRenderer : public Renderer {
+    friend class Object;
+public:
+    const ptr<Chunk> &framebuffer() const noexcept {
+        return _framebuffer;
+    }
+
+    virtual void viewport(unsigned width, unsigned height) noexcept override;
+    virtual ptr<Chunk> readPixels() noexcept override;
+
+protected:
+    SoftRenderer() noexcept {}
+
+    virtual void clear(unsigned color) noexcept override;
+    virtual void draw(const Vertex *vertices, unsigned count, const Batch *batches, unsigned batchCount) noexcept override;
+
+private:
+    struct point {
+        float x, y;
+        float r, g, b, a;
+    };
+    bool project(const Vertex &vertex, point &p) const noexcept;
+    void rasterize(const point &p0, const point &p1, const point &p2, BlendMode blend, bool pmAlpha) noexcept;
+
+    ptr<Chunk> _framebuffer;
+};
+
+GV_NS_END
+
+#endif
+
@@ -0,0 +1,128 @@
+#include "opengxv.h"
+#include <algorithm>
+#include "gv_spatialindex.h"
+
+GV_NS_BEGIN
+
+constexpr unsigned SpatialIndex::leafSize;
+
+static inline Box2f merge(const Box2f &a, const Box2f &b) noexcept {
+    return Box2f(a.min.cwiseMin(b.min), a.max.cwiseMax(b.max));
+}
+
+void SpatialIndex::build(const Box2f *bounds, unsigned count) noexcept {
+    _bounds.assign(bounds, bounds + count);
+    _items.resize(count);
+    for (unsigned i = 0; i < count; ++i) {
+        _items[i] = i;
+    }
+    _nodes.clear();
+    if (count) {
+        _nodes.reserve(count / leafSize * 2 + 1);
+        split(0, count);
+    }
+}
+
+unsigned SpatialIndex::split(unsigned first, unsigned count) noexcept {
+    unsigned index = (unsigned)_nodes.size();
+    _nodes.emplace_back();
+
+    const unsigned *items = _items.data() + first;
+    Box2f bounds = _bounds[items[0]];
+    Vec2f cmin = bounds.center(), cmax = cmin;
+    for (unsigned i = 1; i < count; ++i) {
+        const Box2f &box = _bounds[items[i]];
+        bounds = merge(bounds, box);
+        Vec2f c = box.center();
+        cmin = cmin.cwiseMin(c);
+        cmax = cmax.cwiseMax(c);
+    }
+    _nodes[index].bounds = bounds;
+
+    if (count <= leafSize || cmin == cmax) {
+        _nodes[index].right = 0;
+        _nodes[index].first = first;
+        _nodes[index].count = count;
+        return index;
+    }
+
+    int axis = (cmax.x() - cmin.x()) >= (cmax.y() - cmin.y()) ? 0 : 1;
+    unsigned half = count / 2;
+    auto begin = _items.begin() + first;
+    std::nth_element(begin, begin + half, begin + count, [this, axis](unsigned a, unsigned b) {
+        return _bounds[a].min[axis] + _bounds[a].max[axis] < _bounds[b].min[axis] + _bounds[b].max[axis];
+    });
+
+    split(first, half);
+    unsigned right = split(first + half, count - half);
+    _nodes[index].right = right;
+    _nodes[index].first = first;
+    _nodes[index].count = 0;
+    return index;
+}
+
+void SpatialIndex::refit(const Box2f *bounds, unsigned count) noexcept {
+    gv_assert(count == _bounds.size(), "refit with a different count.");
+    _bounds.assign(bounds, bounds + count);
+
+    // children follow their parent, a reverse pass sees them first
+    for (unsigned i = (unsigned)_nodes.size(); i--; ) {
+        Node &node = _nodes[i];
+        if (node.count) {
+            const unsigned *items = _items.data() + node.first;
+            Box2f box = _bounds[items[0]];
+            for (unsigned n = 1; n < node.count; ++n) {
+                box = merge(box, _bounds[items[n]]);
+            }
+            node.bounds = box;
+        }
+        else {
+            node.bounds = merge(_nodes[i + 1].bounds, _nodes[node.right].bounds);
+        }
+    }
+}
+
+template <typename _Pred>
+void SpatialIndex::query(_Pred pred, std::vector<unsigned> &result) const noexcept {
+    if (_nodes.empty()) {
+        return;
+    }
+    size_t base = result.size();
+    unsigned stack[64];
+    unsigned top = 0;
+    stack[top++] = 0;
+    while (top) {
+        const Node &node = _nodes[stack[--top]];
+        if (!pred(node.bounds)) {
+            continue;
+        }
+        if (node.count) {
+            const unsigned *items = _items.data() + node.first;
+            for (unsigned n = 0; n < node.count; ++n) {
+                if (pred(_bounds[items[n]])) {
+                    result.emplace_back(items[n]);
+                }
+            }
+        }
+        else {
+            stack[top++] = node.right;
+            stack[top++] = (unsigned)(&node - _nodes.data()) + 1;
+        }
+    }
+    std::sort(result.begin() + base, result.end());
+}
+
+void SpatialIndex::query(const Box2f &box, std::vector<unsigned> &result) const noexcept {
+    query([&box](const Box2f &x) {
+        return box.intersects(x);
+    }, result);
+}
+
+void SpatialIndex::query(const Vec2f &point, std::vector<unsigned> &result) const noexcept {
+    query([&point](const Box2f &x) {
+        return x.contains(point);
+    }, result);
+}
+
+GV_NS_END
+
@@ -0,0 +1,78 @@
+#ifndef __GV_SPATIAL_INDEX_H__
+#define __GV_SPATIAL_INDEX_H__
+
+#include <vector>
+
+#include "gv_math.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief A bounding volume hierarchy over a set of boxes, identified
+ *        by their position in the set.
+ *
+ * The nodes are stored flat in pre-order: the left child of a node
+ * follows it, the right one is found by index. build() splits at the
+ * median of the longest axis; when only the boxes moved refit()
+ * recomputes the node bounds without touching the tree.
+ */
+class SpatialIndex {
+public:
+    static constexpr unsigned leafSize = 4;
+
+    SpatialIndex() noexcept {}
+
+    unsigned size() const noexcept {
+        return (unsigned)_bounds.size();
+    }
+    bool empty() const noexcept {
+        return _bounds.empty();
+    }
+    void clear() noexcept {
+        _bounds.clear();
+        _items.clear();
+        _nodes.clear();
+    }
+
+    /**
+     * @brief Rebuilds the tree over bounds[0, count).
+     */
+    void build(const Box2f *bounds, unsigned count) noexcept;
+    /**
+     * @brief Updates the boxes (same count and order as build()) and
+     *        the node bounds.
+     */
+    void refit(const Box2f *bounds, unsigned count) noexcept;
+
+    /**
+     * @brief Appends to result, in ascending order, the items whose
+     *        box overlaps box.
+     */
+    void query(const Box2f &box, std::vector<unsigned> &result) const noexcept;
+    /**
+     * @brief Appends to result, in ascending order, the items whose
+     *        box contains point.
+     */
+    void query(const Vec2f &point, std::vector<unsigned> &result) const noexcept;
+
+private:
+    struct Node {
+        Box2f    bounds;
+        unsigned right;
+        unsigned first;
+        unsigned count;     // 0 for inner nodes
+    };
+
+    unsigned split(unsigned first, unsigned count) noexcept;
+    template <typename _Pred>
+    void query(_Pred pred, std::vector<unsigned> &result) const noexcept;
+
+    std::vector<Box2f>    _bounds;
+    std::vector<unsigned> _items;
+    std::vector<Node>     _nodes;
+};
+
+GV_NS_END
+
+#endif
+
@@ -1,6 +1,10 @@
 #include "opengxv.h"
+#include <cfloat>
 #include "gv_stage.h"
 #include "gv_log.h"
+#include "gv_glrenderer.h"
+#include "gv_softrenderer.h"
+#include "gv_loader.h"
 #include "glfw3.h"
 
 #define GV_STAGE_DEFAULT_WIDTH  1280
@@ -26,6 +30,11 @@ ptr<Event> NativeWindowBoundsEvent::clone() {
     return object<NativeWindowBoundsEvent>(*this);
 }
 
+bool NativeWindowBoundsEvent::coalesce(const Event &next) noexcept {
+    _afterBounds = static_cast<const NativeWindowBoundsEvent&>(next)._afterBounds;
+    return true;
+}
+
 /* NativeWindow */
 NativeWindow::NativeWindow(Stage *stage) 
 : _stage(stage),
@@ -226,6 +235,8 @@ bool NativeWindow::create() {
     return true;
 }
 
+bool Stage::_headless = false;
+
 Stage::Stage() noexcept 
 : _color(0),
   _align(Align::TOP_LEFT),
@@ -235,12 +246,23 @@ Stage::Stage() noexcept
   _monitor(),
   _stageWidth(),
   _stageHeight(),
-  _exit(true)
+  _exit(true),
+  _queueWindowEvents(false),
+  _viewportDirty(false),
+  _viewport(Vec2f(-FLT_MAX, -FLT_MAX), Vec2f(FLT_MAX, FLT_MAX))
 {
+    _stage = this;
     _projection = new Matrix;
 }
 
 bool Stage::init() {
+    if (_headless) {
+        _driverInfo = object<DriverInfo>();
+        _nativeWindow = object<NativeWindow>(this);
+        _renderer = object<SoftRenderer>();
+        return true;
+    }
+
     glfwInit();
 
     glfwSetErrorCallback([](int code, const char*msg) {
@@ -267,6 +289,7 @@ bool Stage::init() {
     }
     _driverInfo = object<DriverInfo>();
     _nativeWindow = object<NativeWindow>(this);
+    _renderer = object<GLRenderer>();
 
     int x, y;
     glfwGetWindowPos(window, &x, &y);
@@ -277,26 +300,27 @@ bool Stage::init() {
     return true;
 }
 
-void draw2(const Matrix &mat) {
+void draw2(Renderer &renderer, const Matrix &mat) {
     static Vec3f pp1(-60.f, -40.f, 0.f);
     static Vec3f pp2(60.f, -40.f, 0.f);
     static Vec3f pp3(0.f, 60.f, 0.f);
-    Vec3f p1, p2, p3;
-
-    p1 = mat * pp1;
-    p2 = mat * pp2;
-    p3 = mat * pp3;
-    glBegin(GL_TRIANGLES);
-    glColor3f(1.f, 0.f, 0.f);
-    glVertex3f(p1.x(), p1.y(), p1.z());
-    glColor3f(0.f, 1.f, 0.f);
-    glVertex3f(p2.x(), p2.y(), p2.z());
-    glColor3f(0.f, 0.f, 1.f);
-    glVertex3f(p3.x(), p3.y(), p3.z());
-    glEnd();
+    Vertex vertices[3] = {
+        Vertex(mat * pp1, 0xffff0000),
+        Vertex(mat * pp2, 0xff00ff00),
+        Vertex(mat * pp3, 0xff0000ff),
+    };
+    renderer.drawTriangles(vertices, 3);
 }
 
 bool Stage::run() noexcept {
+    if (_headless) {
+        _exit = false;
+        while (!_exit) {
+            renderFrame();
+        }
+        return true;
+    }
+
     if (!_nativeWindow->create()) {
         return false;
     }
@@ -340,7 +364,7 @@ bool Stage::run() noexcept {
     updateViewPort();
     //glfwSwapInterval(0);
     while (!_exit) {
-        render();
+        renderFrame();
         glfwSwapBuffers(_nativeWindow->_window);
         glfwPollEvents();
     }
@@ -353,20 +377,40 @@ bool Stage::run() noexcept {
 void Stage::draw(Renderer &renderer, const Matrix &mat) {
 }
 
+void Stage::renderFrame() noexcept {
+    Loader::instance()->update();
+    EventDispatcher::flushEvents();
+    if (_viewportDirty) {
+        _viewportDirty = false;
+        updateViewPort();
+    }
+    if (_headless) {
+        int w, h;
+        framebufferSize(&w, &h);
+        if ((unsigned)w != _renderer->width() || (unsigned)h != _renderer->height()) {
+            if (!_stageWidth) {
+                _stageWidth = w;
+            }
+            if (!_stageHeight) {
+                _stageHeight = h;
+            }
+            updateViewPort();
+        }
+    }
+    render();
+}
+
 void Stage::render() {
-    glClearColor(0, 0, 0, 0);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glMatrixMode(GL_PROJECTION);
-    glLoadMatrixf(_projection->data());
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    _renderer->begin(_color);
+    TransformPool::instance()->update(this);
+    validateBounds();
 
     for (ptr<DisplayObject> child : _container) {
         if (child->_iscontainer) {
-            static_cast<DisplayObjectContainer*>(child.get())->render(*_renderer, *_matrix, (int)_matrixDirty);
+            static_cast<DisplayObjectContainer*>(child.get())->render(*_renderer);
         }
         else {
-            child->render(*_renderer, *_matrix, (int)_matrixDirty);
+            child->render(*_renderer);
         }
     }
     
@@ -375,29 +419,41 @@ void Stage::render() {
 
     Matrix mat;
     mat.setIdentity();
-    draw2(matrix() * mat);
+    draw2(*_renderer, matrix() * mat);
 
     mat.setIdentity();
     mat.translate(Vec3f((float)_stageWidth, 0.f, 0.f));
-    draw2(matrix() * mat);
+    draw2(*_renderer, matrix() * mat);
 
     mat.setIdentity();
     mat.translate(Vec3f(0.f, (float)_stageHeight, 0.f));
-    draw2(matrix() * mat);
+    draw2(*_renderer, matrix() * mat);
 
     mat.setIdentity();
     mat.translate(Vec3f((float)_stageWidth, (float)_stageHeight, 0.f));
-    draw2(matrix() * mat);
+    draw2(*_renderer, matrix() * mat);
+
+    _renderer->end();
+}
+
+void Stage::framebufferSize(int *width, int *height) noexcept {
+    if (_nativeWindow->_window) {
+        glfwGetFramebufferSize(_nativeWindow->_window, width, height);
+    }
+    else {
+        *width = (int)_nativeWindow->width();
+        *height = (int)_nativeWindow->height();
+    }
 }
 
 void Stage::updateViewPort() {
-    if (!_nativeWindow->_window) {
+    if (!_nativeWindow->_window && !_headless) {
         return;
     }
     int w, h;
     float frameWidth, frameHeight, width, height, x = 0, y = 0; 
-    glfwGetFramebufferSize(_nativeWindow->_window, &w, &h);
-    glViewport(0, 0, w, h);
+    framebufferSize(&w, &h);
+    _renderer->viewport(w, h);
     
     frameWidth = (float)w;
     frameHeight = (float)h;
@@ -405,7 +461,7 @@ void Stage::updateViewPort() {
     float sy = frameHeight / _stageHeight;
     float s;
 
-    Matrix &mat = matrix();
+    Matrix mat;
     mat.setIdentity();
     if (_displayState == StageDisplayState::NORMAL) {
         switch (_scaleMode) {
@@ -478,6 +534,7 @@ void Stage::updateViewPort() {
             mat.translate(Vec3f((float)_stageWidth / -2.f, (float)_stageHeight / -2.f, 0.f));
         }
         matrix(mat); 
+        _viewport = Box2f(-frameWidth / 2, -frameHeight / 2, frameWidth, frameHeight);
         math::ortho(
             -frameWidth / 2, 
             frameWidth / 2, 
@@ -486,32 +543,53 @@ void Stage::updateViewPort() {
             -1000,
             1000,
             *_projection);
+        _renderer->projection(*_projection);
     }
 
 }
 
 void Stage::onActive(bool value) {
-    _nativeWindow->dispatchEvent(object<Event>(Event::ACTIVATE));
+    _nativeWindow->dispatchEvent(Event::obtain(Event::ACTIVATE));
+}
+
+void Stage::queueWindowEvents(bool value) noexcept {
+    _queueWindowEvents = value;
+}
+
+void Stage::windowChanged(ptr<Event> event) {
+    if (_queueWindowEvents) {
+        _nativeWindow->queueEvent(event);
+        _viewportDirty = true;
+    }
+    else {
+        _nativeWindow->dispatchEvent(event);
+        updateViewPort();
+    }
 }
 
 void Stage::onPosChanged(int x, int y) {
-    Box2f before(_bounds);
-    _bounds.x((float)x);
-    _bounds.y((float)y);
-    _nativeWindow->dispatchEvent(object<NativeWindowBoundsEvent>(Event::MOVE, before, _nativeWindow->_bounds));
-    updateViewPort();
+    Box2f &bounds = _nativeWindow->_bounds;
+    Box2f before(bounds);
+    bounds.x((float)x);
+    bounds.y((float)y);
+    windowChanged(object<NativeWindowBoundsEvent>(Event::MOVE, before, bounds));
 }
 
 void Stage::onSizeChanged(unsigned width, unsigned height) {
-    Box2f before(_bounds);
-    _bounds.width((float)width);
-    _bounds.height((float)height);
-    _nativeWindow->dispatchEvent(object<NativeWindowBoundsEvent>(Event::RESIZE, before, _nativeWindow->_bounds));
-    updateViewPort();
+    Box2f &bounds = _nativeWindow->_bounds;
+    Box2f before(bounds);
+    bounds.width((float)width);
+    bounds.height((float)height);
+    windowChanged(object<NativeWindowBoundsEvent>(Event::RESIZE, before, bounds));
 }
 
 void Stage::onFramebufferSizeChanged(unsigned width, unsigned height) {
-    updateViewPort();
+    if (_queueWindowEvents) {
+        _viewportDirty = true;
+    }
+    else {
+        updateViewPort();
+    }
 }
 
 void Stage::onClose() {
@@ -540,6 +618,7 @@ void Stage::align(Align value) {
 }
 
 void Stage::color(unsigned value) {
+    _color = value;
 }
 
 void Stage::displayState(StageDisplayState value) {
@@ -557,10 +636,16 @@ void Stage::frameRate(float value) {
 }
 
 unsigned Stage::fullScreenHeight() const {
+    if (!_monitor) {
+        return _nativeWindow->height();
+    }
     return glfwGetVideoMode(_monitor)->height;
 }
 
 unsigned Stage::fullScreenWidth() const {
+    if (!_monitor) {
+        return _nativeWindow->width();
+    }
     return glfwGetVideoMode(_monitor)->width;
 }
 
@@ -568,10 +653,6 @@ bool Stage::allowFullScreen() const {
     return true;
 }
 
-bool Stage::checkVisibility(const Box2f &bounds) noexcept {
-    return true;
-}
-
 void Stage::size(const Size2f&) {
 }
 void Stage::width(float) {
@@ -25,6 +25,7 @@ public:
     NativeWindowBoundsEvent(const ptr<UniStr> &type, const Box2f &beforeBounds, const Box2f &afterBounds) noexcept;
     NativeWindowBoundsEvent(const NativeWindowBoundsEvent &x) noexcept;
     virtual ptr<Event> clone() override;
+    virtual bool coalesce(const Event &next) noexcept override;
 
 private:
     Box2f _beforeBounds;
@@ -138,7 +139,39 @@ class Stage final : public DisplayObjectContainer, public singleton<Stage> {
     friend class Object;
     friend class NativeWindow;
 public:
+    /**
+     * @brief Selects the headless mode, must be called before the 
+     *        first Stage::instance(). A headless stage opens no 
+     *        window and needs no GL context, it renders through a 
+     *        SoftRenderer into a framebuffer sized as the 
+     *        nativeWindow() bounds.
+     */
+    static void headless(bool value) noexcept {
+        _headless = value;
+    }
+    static bool headless() noexcept {
+        return _headless;
+    }
+
     bool run() noexcept;
+
+    /**
+     * @brief Renders a single frame. In headless mode the result 
+     *        can be read back by renderer().readPixels().
+     */
+    void renderFrame() noexcept;
+
+    /**
+     * @brief Whether the window move and resize notifications are 
+     *        queued, coalesced and delivered with a single viewport
+     *        update at the start of the next frame. Off by default,
+     *        each one is then dispatched as it arrives.
+     */
+    bool queueWindowEvents() const noexcept {
+        return _queueWindowEvents;
+    }
+    void queueWindowEvents(bool value) noexcept;
+
     StageScaleMode scaleMode() const noexcept;
     void scaleMode(StageScaleMode value) noexcept;
 
@@ -190,6 +223,10 @@ public:
         return *_driverInfo;
     }
 
+    Renderer &renderer() const noexcept {
+        return *_renderer;
+    }
+
     virtual void size(const Size2f &) override;
     virtual void width(float) override;
     virtual void height(float) override;
@@ -211,7 +248,16 @@ public:
     virtual void scaleZ(float) override;
     virtual void visible(bool) override;
 
-    bool checkVisibility(const Box2f &bounds) noexcept;
+    /**
+     * @brief The visible area in the space the stage matrix maps to, 
+     *        bounds given in that space outside of it are culled.
+     */
+    const Box2f &viewport() const noexcept {
+        return _viewport;
+    }
+    bool checkVisibility(const Box2f &bounds) noexcept {
+        return _viewport.intersects(bounds);
+    }
 protected:
     virtual bool init() override;
 
@@ -223,7 +269,9 @@ private:
     void onSizeChanged(unsigned width, unsigned height);
     void onFramebufferSizeChanged(unsigned width, unsigned height);
     void onClose();
+    void framebufferSize(int *width, int *height) noexcept;
     void updateViewPort();
+    void windowChanged(ptr<Event> event);
     void render();
     virtual void draw(Renderer &renderer, const Matrix &mat) override;
 private:
@@ -239,8 +287,12 @@ private:
     unsigned               _stageWidth;
     unsigned               _stageHeight;
     bool                   _exit;
+    bool                   _queueWindowEvents;
+    bool                   _viewportDirty;
     owned_ptr<Matrix>      _projection;
-    object<Renderer>       _renderer;
+    Box2f                  _viewport;
+    ptr<Renderer>          _renderer;
+    static bool            _headless;
 public:
     Box2f                  fullScreenSourceRect;
 }; 
@@ -2,10 +2,11 @@
 
 #include "gv_texture.h"
 #include "gv_env.h"
+#include "gv_texturecache.h"
 
 GV_NS_BEGIN
 
-Texture::Texture() : _id(), _antialias(true) {}
+Texture::Texture() : _id(), _antialias(true), _pmAlpha(), _width(), _height(), _bytes() {}
 
 Texture::~Texture() {
     if (_id) {
@@ -13,7 +14,7 @@ Texture::~Texture() {
     }
 }
 
-ptr<Texture> Texture::create(Chunk *chunk, unsigned width, unsigned height, const ptr<PixelInfo> &info, size_t count) noexcept {
+ptr<Texture> Texture::create(const ptr<Chunk> *chunk, unsigned width, unsigned height, const ptr<PixelInfo> &info, size_t count, bool pmAlpha) noexcept {
     if (!width || !height || count < 1 || !info->support()) {
         return nullptr;
     }
@@ -43,9 +44,13 @@ ptr<Texture> Texture::create(Chunk *chunk, unsigned width, unsigned height, cons
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, tex->_id);
 
+    // the default minification filter needs mipmaps
     if (count > 1) {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex->_antialias ? GL_LINEAR_MIPMAP_NEAREST : GL_NEAREST_MIPMAP_NEAREST);
     }
+    else {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, tex->_antialias ? GL_LINEAR : GL_NEAREST);
+    }
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, tex->_antialias ? GL_LINEAR : GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -54,15 +59,18 @@ ptr<Texture> Texture::create(Chunk *chunk, unsigned width, unsigned height, cons
     tex->_width = width;
     tex->_height = height;
     tex->_pixelInfo = info;
+    tex->_pmAlpha = pmAlpha;
     for (unsigned int i = 0; i < count; ++i, ++chunk) {
-        unsigned char *data = chunk->data();
-        GLsizei datalen = chunk->size();
+        unsigned char *data = (*chunk)->data();
+        GLsizei datalen = (*chunk)->size();
 
         if (info->compressed()) {
             glCompressedTexImage2D(GL_TEXTURE_2D, i, info->glInternalFormat(), (GLsizei)width, (GLsizei)height, 0, datalen, data);
+            tex->_bytes += datalen;
         }
         else {
             glTexImage2D(GL_TEXTURE_2D, i, info->glInternalFormat(), (GLsizei)width, (GLsizei)height, 0, info->glFormat(), info->glType(), data);
+            tex->_bytes += (size_t)width * height * info->pixelSize();
         }
         if (glGetError() != GL_NO_ERROR) {
             gv_error("gl load texture failed.");
@@ -78,6 +86,21 @@ ptr<Texture> Texture::create(Chunk *chunk, unsigned width, unsigned height, cons
 
 }
 
+bool Texture::update(unsigned x, unsigned y, unsigned width, unsigned height, const void *data) noexcept {
+    if (_pixelInfo->compressed() || x + width > _width || y + height > _height) {
+        return false;
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, _id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (GLint)x, (GLint)y, (GLsizei)width, (GLsizei)height, _pixelInfo->glFormat(), _pixelInfo->glType(), data);
+    if (glGetError() != GL_NO_ERROR) {
+        gv_error("gl update texture failed.");
+        return false;
+    }
+    return true;
+}
+
 ptr<Texture> Texture::create(Image *image, PixelFormat format) noexcept {
     if (image->mipmaps().size() < 1) {
         return nullptr;
@@ -96,29 +119,29 @@ ptr<Texture> Texture::create(Image *image, PixelFormat format) noexcept {
 
     ptr<PixelInfo> texPixelInfo;
     if (!image->pixelInfo()->compressed() && image->mipmaps().size() == 1) {
+        format = Env::instance()->pixelFormat(format);
         if (format == PixelFormat::UNKNOWN) {
-            format = Env::instance()->defaultPixelFormat;
+            format = image->pixelInfo()->smallest(image->mipmaps()[0]->data(), (size_t)image->width() * image->height(),
+                Env::instance()->pixelErrorBound);
         }
         texPixelInfo = PixelInfo::get(format);
         if (!texPixelInfo->support()) {
             gv_warning("unsupport texture pixel format '%s', texture use image pixel format '%s'.", texPixelInfo->desc(), image->pixelInfo()->desc());
             texPixelInfo = image->pixelInfo();
         }
-        else if (texPixelInfo != image->pixelInfo()) {
-            ptr<Chunk> chunk = image->pixelInfo()->convert(image->mipmaps()[0], format);
-            if (!chunk) {
-                gv_warning("can't convert pixel format from '%s' to '%s', texture use image pixel format.", image->pixelInfo()->desc(), texPixelInfo->desc());
-                texPixelInfo = image->pixelInfo();
-            }
-            else {
-                image->mipmaps()[0] = std::move(*chunk);
-            }
+        else if (!image->convert(format, Env::instance()->pixelDither)) {
+            gv_warning("can't convert pixel format from '%s' to '%s', texture use image pixel format.", image->pixelInfo()->desc(), texPixelInfo->desc());
+            texPixelInfo = image->pixelInfo();
         }
     }
     else {
         texPixelInfo = image->pixelInfo();
     }
-    return create(image->mipmaps().data(), image->width(), image->height(), texPixelInfo, image->mipmaps().size());
+    return create(image->mipmaps().data(), image->width(), image->height(), texPixelInfo, image->mipmaps().size(), image->pmAlpha());
+}
+
+ptr<Texture> Texture::create(const ptr<Path> &path, PixelFormat format) noexcept {
+    return TextureCache::instance()->get(path, format);
 }
 
 GV_NS_END
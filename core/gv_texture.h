@@ -10,20 +10,55 @@ GV_NS_BEGIN
 
 class Texture : public Object {
 public:
-    static ptr<Texture> create(Chunk *chunk, unsigned width, unsigned height, const ptr<PixelInfo> &info, size_t count = 1) noexcept;
+    static ptr<Texture> create(const ptr<Chunk> *chunk, unsigned width, unsigned height, const ptr<PixelInfo> &info, size_t count = 1,
+                               bool pmAlpha = false) noexcept;
     static ptr<Texture> create(Image *image, PixelFormat format) noexcept;
     static ptr<Texture> create(const ptr<Path> &path, PixelFormat format = PixelFormat::UNKNOWN) noexcept;
 
     Texture();
 
+    GLuint id() const noexcept {
+        return _id;
+    }
+    unsigned width() const noexcept {
+        return _width;
+    }
+    unsigned height() const noexcept {
+        return _height;
+    }
+    const ptr<PixelInfo> &pixelInfo() const noexcept {
+        return _pixelInfo;
+    }
+    /**
+     * @brief Whether the colors are premultiplied by alpha, the
+     *        renderer blends them accordingly.
+     */
+    bool pmAlpha() const noexcept {
+        return _pmAlpha;
+    }
+    /**
+     * @brief The video memory taken by all the levels.
+     */
+    size_t bytes() const noexcept {
+        return _bytes;
+    }
+
+    /**
+     * @brief Replaces a region of the base level, data has the pixel
+     *        format of the texture, rows packed. From the GL thread.
+     */
+    bool update(unsigned x, unsigned y, unsigned width, unsigned height, const void *data) noexcept;
+
 protected:
     ~Texture();
 private:
     ptr<PixelInfo> _pixelInfo;
     GLuint _id;
     bool _antialias;
+    bool _pmAlpha;
     unsigned _width;
     unsigned _height;
+    size_t _bytes;
 };
 
 GV_NS_END
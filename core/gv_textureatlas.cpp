@@ -0,0 +1,214 @@
+#include "opengxv.h"
+#include <algorithm>
+#include "gv_textureatlas.h"
+#include "gv_image.h"
+#include "gv_env.h"
+#include "gv_log.h"
+
+GV_NS_BEGIN
+
+/* SkylinePacker */
+SkylinePacker::SkylinePacker(unsigned width, unsigned height) noexcept
+: _width(width),
+  _height(height),
+  _used()
+{
+    clear();
+}
+
+void SkylinePacker::clear() noexcept {
+    _skyline.clear();
+    _skyline.push_back(Node{0, 0, _width});
+    _used = 0;
+}
+
+/* the rectangle placed at the left of node index rests on the highest
+ * of the nodes it spans */
+bool SkylinePacker::fit(size_t index, unsigned width, unsigned height, unsigned &y) const noexcept {
+    unsigned x = _skyline[index].x;
+    if (x + width > _width) {
+        return false;
+    }
+    y = 0;
+    for (unsigned spanned = 0; spanned < width; ++index) {
+        const Node &node = _skyline[index];
+        y = std::max(y, node.y);
+        if (y + height > _height) {
+            return false;
+        }
+        spanned += node.width;
+    }
+    return true;
+}
+
+bool SkylinePacker::insert(unsigned width, unsigned height, unsigned &x, unsigned &y) noexcept {
+    if (!width || !height) {
+        return false;
+    }
+
+    size_t best = _skyline.size();
+    unsigned bestTop = ~0u, bestWidth = ~0u, top;
+    for (size_t i = 0; i < _skyline.size(); ++i) {
+        if (fit(i, width, height, top)) {
+            top += height;
+            if (top < bestTop || (top == bestTop && _skyline[i].width < bestWidth)) {
+                best = i;
+                bestTop = top;
+                bestWidth = _skyline[i].width;
+            }
+        }
+    }
+    if (best == _skyline.size()) {
+        return false;
+    }
+
+    x = _skyline[best].x;
+    y = bestTop - height;
+    _skyline.insert(_skyline.begin() + best, Node{x, bestTop, width});
+
+    // the nodes now under the rectangle are cut or dropped
+    for (size_t i = best + 1; i < _skyline.size(); ) {
+        Node &prev = _skyline[i - 1];
+        Node &node = _skyline[i];
+        unsigned end = prev.x + prev.width;
+        if (node.x >= end) {
+            break;
+        }
+        unsigned shrink = end - node.x;
+        if (node.width <= shrink) {
+            _skyline.erase(_skyline.begin() + i);
+            continue;
+        }
+        node.x += shrink;
+        node.width -= shrink;
+        break;
+    }
+
+    for (size_t i = 1; i < _skyline.size(); ) {
+        if (_skyline[i - 1].y == _skyline[i].y) {
+            _skyline[i - 1].width += _skyline[i].width;
+            _skyline.erase(_skyline.begin() + i);
+        }
+        else {
+            ++i;
+        }
+    }
+
+    _used += (size_t)width * height;
+    return true;
+}
+
+/* SubTexture */
+SubTexture::SubTexture(Texture *texture, unsigned x, unsigned y, unsigned width, unsigned height) noexcept
+: _texture(texture),
+  _uv((float)x / texture->width(), (float)y / texture->height(),
+      (float)width / texture->width(), (float)height / texture->height()),
+  _x(x),
+  _y(y),
+  _width(width),
+  _height(height)
+{ }
+
+/* TextureAtlas */
+TextureAtlas::TextureAtlas(unsigned pageSize, const ptr<PixelInfo> &info, unsigned padding) noexcept
+: _pixelInfo(info),
+  _pageSize(pageSize),
+  _padding(padding),
+  _pmAlpha(Env::instance()->premultiplyAlpha)
+{ }
+
+ptr<TextureAtlas> TextureAtlas::create(unsigned pageSize, PixelFormat format, unsigned padding) noexcept {
+    if (format == PixelFormat::UNKNOWN) {
+        format = Env::instance()->defaultPixelFormat;
+    }
+    ptr<PixelInfo> info = PixelInfo::get(format);
+    if (!info->support() || info->compressed()) {
+        gv_error("unsupport atlas pixel format '%s'.", info->desc());
+        return nullptr;
+    }
+    pageSize = std::min(pageSize, (unsigned)Env::instance()->maxTextureSize());
+    if (pageSize <= padding) {
+        return nullptr;
+    }
+    return object<TextureAtlas>(pageSize, info, padding);
+}
+
+bool TextureAtlas::addPage() noexcept {
+    // cleared, the padding is sampled by the filtering
+    ptr<Chunk> chunk = object<Chunk>(_pixelInfo->pixelSize() * _pageSize * _pageSize);
+    std::memset(chunk->data(), 0, chunk->size());
+    ptr<Texture> texture = Texture::create(&chunk, _pageSize, _pageSize, _pixelInfo, 1, _pmAlpha);
+    if (!texture) {
+        return false;
+    }
+    _pages.emplace_back(texture, _pageSize);
+    return true;
+}
+
+ptr<SubTexture> TextureAtlas::add(Image *image) noexcept {
+    unsigned width = image->width();
+    unsigned height = image->height();
+    bool alpha = image->pixelInfo()->alpha();
+    if (image->mipmaps().size() != 1 ||
+        image->pixelInfo()->compressed() ||
+        (alpha && image->pmAlpha() && !_pmAlpha) ||
+        width + _padding > _pageSize ||
+        height + _padding > _pageSize) {
+        ptr<Texture> texture = Texture::create(image, _pixelInfo->format());
+        if (!texture) {
+            return nullptr;
+        }
+        return object<SubTexture>(texture, 0, 0, width, height);
+    }
+
+    ptr<Chunk> converted;
+    const Chunk *pixels = image->mipmaps()[0].get();
+    if (alpha && !image->pmAlpha() && _pmAlpha) {
+        converted = object<Chunk>(pixels->data(), pixels->size());
+        if (!image->pixelInfo()->premultiply(converted->data(), (size_t)width * height)) {
+            gv_error("can't premultiply pixel format '%s'.", image->pixelInfo()->desc());
+            return nullptr;
+        }
+        pixels = converted.get();
+    }
+    if (image->pixelInfo() != _pixelInfo) {
+        converted = image->pixelInfo()->convert(*pixels, width, height, _pixelInfo->format(), Env::instance()->pixelDither);
+        if (!converted) {
+            gv_error("can't convert pixel format from '%s' to '%s'.", image->pixelInfo()->desc(), _pixelInfo->desc());
+            return nullptr;
+        }
+        pixels = converted.get();
+    }
+
+    // the last pages are tried first, the older ones are mostly full
+    unsigned x, y;
+    Page *page = nullptr;
+    for (auto it = _pages.rbegin(); it != _pages.rend(); ++it) {
+        if (it->packer.insert(width + _padding, height + _padding, x, y)) {
+            page = &*it;
+            break;
+        }
+    }
+    if (!page) {
+        if (!addPage() || !_pages.back().packer.insert(width + _padding, height + _padding, x, y)) {
+            return nullptr;
+        }
+        page = &_pages.back();
+    }
+
+    if (!page->texture->update(x, y, width, height, pixels->data())) {
+        return nullptr;
+    }
+    return object<SubTexture>(page->texture, x, y, width, height);
+}
+
+ptr<SubTexture> TextureAtlas::add(const ptr<Path> &path) noexcept {
+    ptr<Image> image = Image::load(path, FileType::UNKNOWN, _pixelInfo->format(), Env::instance()->pixelDither, _pmAlpha);
+    if (!image) {
+        return nullptr;
+    }
+    return add(image.get());
+}
+
+GV_NS_END
+
@@ -0,0 +1,146 @@
+#ifndef __GV_TEXTURE_ATLAS_H__
+#define __GV_TEXTURE_ATLAS_H__
+
+#include <vector>
+
+#include "gv_object.h"
+#include "gv_math.h"
+#include "gv_texture.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief Packs rectangles into a fixed size page. The skyline is the
+ *        top edge of what is packed so far, a rectangle goes where its
+ *        top is the lowest (bottom-left rule).
+ */
+class SkylinePacker {
+public:
+    SkylinePacker(unsigned width, unsigned height) noexcept;
+
+    /**
+     * @brief Places a rectangle, returns false if the page is full.
+     */
+    bool insert(unsigned width, unsigned height, unsigned &x, unsigned &y) noexcept;
+    void clear() noexcept;
+
+    unsigned width() const noexcept {
+        return _width;
+    }
+    unsigned height() const noexcept {
+        return _height;
+    }
+    /**
+     * @brief The packed area over the page area.
+     */
+    float occupancy() const noexcept {
+        return (float)_used / ((float)_width * _height);
+    }
+
+private:
+    struct Node {
+        unsigned x, y, width;
+    };
+    bool fit(size_t index, unsigned width, unsigned height, unsigned &y) const noexcept;
+
+    std::vector<Node> _skyline;
+    unsigned _width;
+    unsigned _height;
+    size_t _used;
+};
+
+/**
+ * @brief A region of a texture, the sprites drawn from the regions of
+ *        one atlas page share its texture and batch into one draw.
+ */
+class SubTexture : public Object {
+    friend class Object;
+    friend class TextureAtlas;
+public:
+    Texture *texture() const noexcept {
+        return _texture;
+    }
+    /**
+     * @brief The texture coordinates of the region, min is the top
+     *        left corner.
+     */
+    const Box2f &uv() const noexcept {
+        return _uv;
+    }
+    unsigned x() const noexcept {
+        return _x;
+    }
+    unsigned y() const noexcept {
+        return _y;
+    }
+    unsigned width() const noexcept {
+        return _width;
+    }
+    unsigned height() const noexcept {
+        return _height;
+    }
+
+private:
+    SubTexture(Texture *texture, unsigned x, unsigned y, unsigned width, unsigned height) noexcept;
+
+    ptr<Texture> _texture;
+    Box2f        _uv;
+    unsigned     _x;
+    unsigned     _y;
+    unsigned     _width;
+    unsigned     _height;
+};
+
+/**
+ * @brief Packs images into shared texture pages as they are loaded.
+ *        A page is added when none has room, an image too big for a
+ *        page or which can't be copied into one (compressed, with
+ *        mipmaps, premultiplied into straight pages) gets a texture
+ *        of its own. From the GL thread.
+ */
+class TextureAtlas : public Object {
+    friend class Object;
+public:
+    /**
+     * @brief The pages are pageSize square, in format, Env's default
+     *        if unknown. padding pixels are left around each image so
+     *        that filtering doesn't sample the neighbours.
+     */
+    static ptr<TextureAtlas> create(unsigned pageSize = 1024, PixelFormat format = PixelFormat::UNKNOWN, unsigned padding = 1) noexcept;
+
+    ptr<SubTexture> add(Image *image) noexcept;
+    ptr<SubTexture> add(const ptr<Path> &path) noexcept;
+
+    unsigned pageCount() const noexcept {
+        return (unsigned)_pages.size();
+    }
+    Texture *page(unsigned index) const noexcept {
+        return _pages[index].texture;
+    }
+    float occupancy(unsigned index) const noexcept {
+        return _pages[index].packer.occupancy();
+    }
+
+private:
+    TextureAtlas(unsigned pageSize, const ptr<PixelInfo> &info, unsigned padding) noexcept;
+
+    struct Page {
+        Page(Texture *tex, unsigned size) noexcept : texture(tex), packer(size, size) {}
+
+        ptr<Texture>  texture;
+        SkylinePacker packer;
+    };
+    bool addPage() noexcept;
+
+    std::vector<Page> _pages;
+    ptr<PixelInfo>    _pixelInfo;
+    unsigned          _pageSize;
+    unsigned          _padding;
+    /* of the pages, Env's premultiplyAlpha when created */
+    bool              _pmAlpha;
+};
+
+GV_NS_END
+
+#endif
+
@@ -0,0 +1,103 @@
+#include "opengxv.h"
+#include "gv_texturecache.h"
+#include "gv_image.h"
+
+GV_NS_BEGIN
+
+TextureCache::TextureCache() noexcept
+: _budget(DEFAULT_BUDGET),
+  _stats()
+{ }
+
+TextureCache::~TextureCache() noexcept {
+    clear();
+}
+
+ptr<Texture> TextureCache::find(const ptr<Path> &path, PixelFormat format) noexcept {
+    auto it = _map.find(makeKey(path, format));
+    if (it == _map.end()) {
+        ++_stats.misses;
+        return nullptr;
+    }
+    ++_stats.hits;
+    Entry &entry = it->second;
+    lru_type::remove(&entry);
+    _lru.push_front(&entry);
+    return entry._texture;
+}
+
+ptr<Texture> TextureCache::get(const ptr<Path> &path, PixelFormat format) noexcept {
+    ptr<Texture> texture = find(path, format);
+    if (texture) {
+        return texture;
+    }
+
+    // decoded straight to the texture format, an automatic one is
+    // picked from the decoded pixels
+    format = makeKey(path, format).format;
+    ptr<Image> image = Image::load(path, FileType::UNKNOWN, format, Env::instance()->pixelDither,
+        Env::instance()->premultiplyAlpha);
+    if (!image) {
+        return nullptr;
+    }
+    texture = Texture::create(image.get(), format);
+    if (texture) {
+        put(path, format, texture);
+    }
+    return texture;
+}
+
+void TextureCache::put(const ptr<Path> &path, PixelFormat format, Texture *texture) noexcept {
+    key k = makeKey(path, format);
+    auto it = _map.find(k);
+    if (it != _map.end()) {
+        erase(it);
+    }
+
+    Entry &entry = _map[k];
+    entry._path = path;
+    entry._format = k.format;
+    entry._texture = texture;
+    _lru.push_front(&entry);
+    ++_stats.count;
+    _stats.bytes += texture->bytes();
+    trim();
+}
+
+void TextureCache::remove(const ptr<Path> &path, PixelFormat format) noexcept {
+    auto it = _map.find(makeKey(path, format));
+    if (it != _map.end()) {
+        erase(it);
+    }
+}
+
+void TextureCache::erase(map_type::iterator it) noexcept {
+    Entry &entry = it->second;
+    lru_type::remove(&entry);
+    --_stats.count;
+    _stats.bytes -= entry._texture->bytes();
+    _map.erase(it);
+}
+
+void TextureCache::clear() noexcept {
+    while (!_map.empty()) {
+        erase(_map.begin());
+    }
+}
+
+void TextureCache::trim() noexcept {
+    // a texture still in use stays in video memory whether cached or
+    // not, dropping it would only cost a second upload
+    Entry *entry = _lru.back();
+    while (_stats.bytes > _budget && entry) {
+        Entry *prev = _lru.prev(entry);
+        if (ref_count(entry->_texture) == 1) {
+            erase(_map.find(key{entry->_path, entry->_format}));
+            ++_stats.evictions;
+        }
+        entry = prev;
+    }
+}
+
+GV_NS_END
+
@@ -0,0 +1,110 @@
+#ifndef __GV_TEXTURE_CACHE_H__
+#define __GV_TEXTURE_CACHE_H__
+
+#include <unordered_map>
+
+#include "gv_object.h"
+#include "gv_singleton.h"
+#include "gv_list.h"
+#include "gv_path.h"
+#include "gv_env.h"
+#include "gv_texture.h"
+
+GV_NS_BEGIN
+
+/**
+ * @brief Keeps the textures loaded from a path, per pixel format, so
+ *        that each is decoded and uploaded once. Past the budget the
+ *        least recently used textures nobody else holds are released.
+ */
+class TextureCache : public Object, public singleton<TextureCache, Env> {
+    friend class Object;
+public:
+    enum {
+        DEFAULT_BUDGET = 64 * 1024 * 1024,
+    };
+
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t count;
+        size_t bytes;
+    };
+
+    ~TextureCache() noexcept;
+
+    /**
+     * @brief The texture of path, loaded on a miss, see Texture::create().
+     */
+    ptr<Texture> get(const ptr<Path> &path, PixelFormat format = PixelFormat::UNKNOWN) noexcept;
+    /**
+     * @brief The cached texture of path, nullptr on a miss.
+     */
+    ptr<Texture> find(const ptr<Path> &path, PixelFormat format = PixelFormat::UNKNOWN) noexcept;
+    /**
+     * @brief Caches a texture loaded elsewhere, the Loader one's.
+     */
+    void put(const ptr<Path> &path, PixelFormat format, Texture *texture) noexcept;
+    void remove(const ptr<Path> &path, PixelFormat format = PixelFormat::UNKNOWN) noexcept;
+    void clear() noexcept;
+
+    size_t budget() const noexcept {
+        return _budget;
+    }
+    void budget(size_t value) noexcept {
+        _budget = value;
+        trim();
+    }
+    /**
+     * @brief Releases the least recently used textures held by the
+     *        cache only until the resident bytes fit the budget.
+     */
+    void trim() noexcept;
+
+    const Stats &stats() const noexcept {
+        return _stats;
+    }
+
+private:
+    TextureCache() noexcept;
+
+    struct key {
+        Path        *path;
+        PixelFormat  format;
+
+        bool operator==(const key &rhs) const noexcept {
+            return path == rhs.path && format == rhs.format;
+        }
+    };
+    struct key_hash {
+        size_t operator()(const key &x) const noexcept {
+            return std::hash<Path*>()(x.path) ^ ((size_t)x.format << 3);
+        }
+    };
+    /* the path is held, its address keys the entry */
+    struct Entry {
+        clist_entry  _lru;
+        ptr<Path>    _path;
+        PixelFormat  _format;
+        ptr<Texture> _texture;
+    };
+    typedef std::unordered_map<key, Entry, key_hash> map_type;
+    typedef gv_list(Entry, _lru) lru_type;
+
+    /* UNKNOWN keys the textures of automatic formats */
+    static key makeKey(Path *path, PixelFormat format) noexcept {
+        return key{path, Env::instance()->pixelFormat(format)};
+    }
+    void erase(map_type::iterator it) noexcept;
+
+    map_type _map;
+    lru_type _lru;
+    size_t   _budget;
+    Stats    _stats;
+};
+
+GV_NS_END
+
+#endif
+
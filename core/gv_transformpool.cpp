@@ -0,0 +1,152 @@
+#include "opengxv.h"
+#include "gv_transformpool.h"
+#include "gv_displayobjectcontainer.h"
+
+GV_NS_BEGIN
+
+constexpr unsigned TransformPool::npos;
+
+unsigned TransformPool::alloc(DisplayObject *owner) noexcept {
+    unsigned index;
+    if (_free.empty()) {
+        index = (unsigned)_owners.size();
+        _locals.emplace_back();
+        _worlds.emplace_back();
+        _flatLocals.emplace_back();
+        _flatWorlds.emplace_back();
+        _parents.emplace_back(npos);
+        _flags.emplace_back(0);
+        _owners.emplace_back(owner);
+    }
+    else {
+        index = _free.back();
+        _free.pop_back();
+        _parents[index] = npos;
+        _owners[index] = owner;
+    }
+    _locals[index].setIdentity();
+    _worlds[index].setIdentity();
+    _flatLocals[index].setIdentity();
+    _flatWorlds[index].setIdentity();
+    _flags[index] = LOCAL_FLAT | WORLD_FLAT | WORLD_EXPANDED;
+    return index;
+}
+
+void TransformPool::free(unsigned index) noexcept {
+    _parents[index] = npos;
+    _flags[index] = 0;
+    _owners[index] = nullptr;
+    _free.emplace_back(index);
+}
+
+/* computes the concatenated matrix of index from the one of parent, in
+ * the 2x3 form as long as both are flat */
+inline unsigned char TransformPool::concatenate(unsigned index, unsigned parent, unsigned char flags) noexcept {
+    if ((flags & LOCAL_FLAT) && (parent == npos || (_flags[parent] & WORLD_FLAT))) {
+        if (parent == npos) {
+            _flatWorlds[index] = _flatLocals[index];
+        }
+        else {
+            _flatWorlds[index] = _flatWorlds[parent] * _flatLocals[index];
+        }
+        return (flags | WORLD_FLAT) & ~WORLD_EXPANDED;
+    }
+    if (parent == npos) {
+        _worlds[index] = _locals[index];
+    }
+    else {
+        _worlds[index] = world(parent) * _locals[index];
+    }
+    return (flags & ~WORLD_FLAT) | WORLD_EXPANDED;
+}
+
+const Matrix &TransformPool::concatenate(unsigned index) noexcept {
+    unsigned parent = _parents[index];
+    if (parent != npos) {
+        concatenate(parent);
+    }
+    unsigned char flags = _flags[index];
+    if (flags & LOCAL_DIRTY) {
+        flags = refreshLocal(index, flags);
+    }
+    _flags[index] = concatenate(index, parent, flags);
+    return world(index);
+}
+
+void TransformPool::update(DisplayObject *root) noexcept {
+    if (_layoutDirty) {
+        layout(root);
+    }
+
+    // parents come first, a single pass sees every parent already updated
+    unsigned size = (unsigned)_owners.size();
+    const unsigned *parents = _parents.data();
+    unsigned char *flags = _flags.data();
+    for (unsigned i = 0; i < size; ++i) {
+        unsigned parent = parents[i];
+        unsigned char f = flags[i];
+        if (f & LOCAL_DIRTY) {
+            f = refreshLocal(i, f & ~LOCAL_DIRTY);
+        }
+        else if (parent == npos || !(flags[parent] & WORLD_CHANGED)) {
+            flags[i] = f & ~WORLD_CHANGED;
+            continue;
+        }
+        flags[i] = concatenate(i, parent, f) | WORLD_CHANGED;
+    }
+}
+
+void TransformPool::visit(DisplayObject *obj, unsigned parent) noexcept {
+    unsigned index = obj->_transform;
+    unsigned n = (unsigned)_newOwners.size();
+    _remap[index] = n;
+    _newLocals.emplace_back(_locals[index]);
+    _newWorlds.emplace_back(_worlds[index]);
+    _newFlatLocals.emplace_back(_flatLocals[index]);
+    _newFlatWorlds.emplace_back(_flatWorlds[index]);
+    _newParents.emplace_back(parent);
+    _newFlags.emplace_back(_flags[index]);
+    _newOwners.emplace_back(obj);
+    obj->_transform = n;
+
+    if (obj->_iscontainer) {
+        for (auto child : static_cast<DisplayObjectContainer*>(obj)->_container) {
+            visit(child, n);
+        }
+    }
+}
+
+void TransformPool::layout(DisplayObject *root) noexcept {
+    unsigned size = (unsigned)_owners.size();
+    _remap.assign(size, npos);
+    _newLocals.clear();
+    _newWorlds.clear();
+    _newFlatLocals.clear();
+    _newFlatWorlds.clear();
+    _newParents.clear();
+    _newFlags.clear();
+    _newOwners.clear();
+
+    // the stage tree first, then the detached trees
+    if (root) {
+        visit(root, npos);
+    }
+    for (unsigned i = 0; i < size; ++i) {
+        if (_owners[i] && _parents[i] == npos && _remap[i] == npos) {
+            visit(_owners[i], npos);
+        }
+    }
+
+    _locals.swap(_newLocals);
+    _worlds.swap(_newWorlds);
+    _flatLocals.swap(_newFlatLocals);
+    _flatWorlds.swap(_newFlatWorlds);
+    _parents.swap(_newParents);
+    _flags.swap(_newFlags);
+    _owners.swap(_newOwners);
+    _free.clear();
+    _layoutDirty = false;
+}
+
+GV_NS_END
+
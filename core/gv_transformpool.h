@@ -0,0 +1,144 @@
+#ifndef __GV_TRANSFORM_POOL_H__
+#define __GV_TRANSFORM_POOL_H__
+
+#include <vector>
+
+#include "gv_object.h"
+#include "gv_singleton.h"
+#include "gv_math.h"
+
+GV_NS_BEGIN
+
+class DisplayObject;
+
+/**
+ * @brief The TransformPool class stores the local and concatenated
+ *        matrices of all display objects in flat arrays, a node only
+ *        keeps its index.
+ *
+ * The slots are kept so that a parent always comes before its
+ * children, depth-first from the stage after each relayout. update()
+ * then propagates the concatenated matrices in one linear sweep.
+ */
+class TransformPool : public Object, public singleton<TransformPool> {
+    friend class Object;
+public:
+    static constexpr unsigned npos = (unsigned)-1;
+
+    unsigned alloc(DisplayObject *owner) noexcept;
+    void free(unsigned index) noexcept;
+
+    Matrix &local(unsigned index) noexcept {
+        return _locals[index];
+    }
+    /**
+     * @brief The concatenated matrix of index. Flat nodes only keep a
+     *        Matrix2D, the 4x4 form is built on first use.
+     */
+    Matrix &world(unsigned index) noexcept {
+        if (!(_flags[index] & WORLD_EXPANDED)) {
+            _flatWorlds[index].expand(_worlds[index]);
+            _flags[index] |= WORLD_EXPANDED;
+        }
+        return _worlds[index];
+    }
+    bool flat(unsigned index) const noexcept {
+        return (_flags[index] & WORLD_FLAT) != 0;
+    }
+    const Matrix2D &flatWorld(unsigned index) const noexcept {
+        return _flatWorlds[index];
+    }
+    /**
+     * @brief Transforms box by the concatenated matrix of index.
+     */
+    Box2f transform(unsigned index, const Box2f &box) noexcept {
+        if (_flags[index] & WORLD_FLAT) {
+            return _flatWorlds[index] * box;
+        }
+        return world(index) * box;
+    }
+
+    /**
+     * @brief The local matrix of index changed.
+     */
+    void dirty(unsigned index) noexcept {
+        _flags[index] |= LOCAL_DIRTY;
+    }
+    /**
+     * @brief The concatenated matrix of index was recomputed by the
+     *        last update().
+     */
+    bool changed(unsigned index) const noexcept {
+        return (_flags[index] & WORLD_CHANGED) != 0;
+    }
+
+    void attach(unsigned index, unsigned parent) noexcept {
+        _parents[index] = parent;
+        if (index < parent) {
+            _layoutDirty = true;
+        }
+    }
+    void detach(unsigned index) noexcept {
+        _parents[index] = npos;
+    }
+
+    /**
+     * @brief Computes the concatenated matrix of index through its
+     *        ancestors, for use between two update().
+     */
+    const Matrix &concatenate(unsigned index) noexcept;
+
+    /**
+     * @brief Relayouts depth-first from root if the tree changed, then
+     *        recomputes the dirty concatenated matrices.
+     */
+    void update(DisplayObject *root) noexcept;
+
+private:
+    enum {
+        LOCAL_DIRTY     = 1,
+        WORLD_CHANGED   = 2,
+        LOCAL_FLAT      = 4,
+        WORLD_FLAT      = 8,
+        WORLD_EXPANDED  = 16,
+    };
+    typedef std::vector<Matrix, Eigen::aligned_allocator<Matrix>> Matrices;
+    typedef std::vector<Matrix2D> FlatMatrices;
+
+    TransformPool() noexcept : _layoutDirty(false) {}
+    void layout(DisplayObject *root) noexcept;
+    void visit(DisplayObject *obj, unsigned parent) noexcept;
+    unsigned char refreshLocal(unsigned index, unsigned char flags) noexcept {
+        if (Matrix2D::flat(_locals[index])) {
+            _flatLocals[index] = Matrix2D(_locals[index]);
+            return flags | LOCAL_FLAT;
+        }
+        return flags & ~LOCAL_FLAT;
+    }
+    unsigned char concatenate(unsigned index, unsigned parent, unsigned char flags) noexcept;
+
+    Matrices                    _locals;
+    Matrices                    _worlds;
+    FlatMatrices                _flatLocals;
+    FlatMatrices                _flatWorlds;
+    std::vector<unsigned>       _parents;
+    std::vector<unsigned char>  _flags;
+    std::vector<DisplayObject*> _owners;
+    std::vector<unsigned>       _free;
+    bool                        _layoutDirty;
+
+    /* scratch arrays of layout() */
+    Matrices                    _newLocals;
+    Matrices                    _newWorlds;
+    FlatMatrices                _newFlatLocals;
+    FlatMatrices                _newFlatWorlds;
+    std::vector<unsigned>       _newParents;
+    std::vector<unsigned char>  _newFlags;
+    std::vector<DisplayObject*> _newOwners;
+    std::vector<unsigned>       _remap;
+};
+
+GV_NS_END
+
+#endif
+
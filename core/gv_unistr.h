@@ -4,6 +4,7 @@
 #include <unordered_set>
 #include <string>
 #include <cstdlib>
+#include <cstring>
 
 #include "gv_object.h"
 #include "gv_hash.h"
@@ -2,7 +2,11 @@
 #define __GV_XML_H__
 
 #include <string>
+#include <vector>
+#include <cstring>
 #include "gv_object.h"
+#include "gv_chunk.h"
+#include "gv_log.h"
 
 GV_NS_BEGIN
 
@@ -0,0 +1,171 @@
+#include "opengxv.h"
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "gv_rbmap.h"
+#include "gv_unistr.h"
+#include "gv_event.h"
+#include "gv_eventdispatcher.h"
+
+using namespace gv;
+
+/* times dispatching an event to its target: EventDispatcher, which keeps
+ * per phase vectors in a hash table by type, against the dispatch it
+ * replaced, the listeners of every type and phase in one rbmap ordered
+ * by type, phase and priority. The old dispatch is gone, it's kept here
+ * as it was, its lookup made to always find the first listener */
+
+enum {
+    ROUNDS = 100000,
+};
+
+class RbmapStub : public Object {
+    friend class Object;
+public:
+    map_entry    _entry;
+    ptr<UniStr>  _name;
+    int          _capture;
+    int          _priority;
+    unsigned     _serial;
+    Object      *_holder;
+    int         *_sum;
+
+    virtual void operator()(ptr<Event>&) noexcept {
+        *_sum += _priority + 1;
+    }
+protected:
+    RbmapStub(const ptr<UniStr> &name, int capture, int priority, unsigned serial, int *sum) noexcept :
+        _name(name),
+        _capture(capture),
+        _priority(priority),
+        _serial(serial),
+        _holder(),
+        _sum(sum) { }
+};
+
+struct compare {
+    int operator()(const RbmapStub &lhs, const RbmapStub &rhs) const noexcept {
+        if (lhs._name != rhs._name) {
+            return lhs._name < rhs._name ? -1 : 1;
+        }
+        if (lhs._capture != rhs._capture) {
+            return lhs._capture < rhs._capture ? -1 : 1;
+        }
+        if (lhs._priority != rhs._priority) {
+            return lhs._priority > rhs._priority ? -1 : 1;
+        }
+        return lhs._serial < rhs._serial ? -1 : 1;
+    }
+};
+
+class RbmapDispatcher {
+public:
+    typedef gv_map(RbmapStub, RbmapStub, _entry, compare) map_type;
+
+    void add(const ptr<RbmapStub> &stub) {
+        _map.emplace(*stub, [=]() { return stub.get(); });
+        _stubs.emplace_back(stub);
+    }
+
+    bool dispatchEvent(ptr<Event> event) {
+        if (event->target()) {
+            event = event->clone();
+        }
+        int capture = 1;
+        RbmapStub *stub = nullptr;
+        _map.find(event->type(), [&](const ptr<UniStr> &lhs, const RbmapStub &rhs) noexcept {
+            if (lhs != rhs._name) {
+                return lhs < rhs._name ? -1 : 1;
+            }
+            if (capture != rhs._capture) {
+                return capture < rhs._capture ? -1 : 1;
+            }
+            stub = const_cast<RbmapStub*>(&rhs);
+            return -1;
+        });
+        if (!stub) {
+            return false;
+        }
+
+        struct context {
+            context() noexcept {}
+            context(RbmapStub *stub, Object *holder) noexcept :
+                _stub(stub),
+                _holder(holder) {}
+
+            ptr<RbmapStub> _stub;
+            ptr<Object> _holder;
+        };
+        static std::vector<context> ctxs;
+        size_t old_size = ctxs.size();
+        do {
+            ctxs.emplace_back(stub, stub->_holder);
+            stub = map_type::next(stub);
+        } while (stub && stub->_name == event->type() && stub->_capture == capture);
+        for (size_t i = old_size; i < ctxs.size(); ++i) {
+            (*ctxs[i]._stub)(event);
+        }
+        ctxs.resize(old_size);
+        return event->isDefaultPrevented();
+    }
+
+private:
+    map_type _map;
+    std::vector<ptr<RbmapStub>> _stubs;
+};
+
+static void run(unsigned typeCount, unsigned listenerCount) {
+    std::vector<ptr<UniStr>> types;
+    for (unsigned i = 0; i < typeCount * 2; ++i) {
+        types.emplace_back(unistr("type" + std::to_string(i)));
+    }
+
+    // half the types are listened in both phases, the others are missed
+    int sums[2] = {};
+    RbmapDispatcher rbmap;
+    ptr<EventDispatcher> dispatcher = object<EventDispatcher>();
+    std::vector<ptr<EventListenerStub>> stubs;
+    unsigned serial = 0;
+    for (unsigned i = 0; i < typeCount; ++i) {
+        for (int capture = 0; capture < 2; ++capture) {
+            for (unsigned j = 0; j < listenerCount; ++j) {
+                int priority = (int)(j % 3);
+                rbmap.add(object<RbmapStub>(types[i * 2], capture, priority, serial++, &sums[0]));
+                int *sum = &sums[1];
+                stubs.emplace_back(dispatcher->addEventListener(types[i * 2], nullptr, [=](ptr<Event>&) {
+                    *sum += priority + 1;
+                }, capture == 0, priority));
+            }
+        }
+    }
+
+    typedef std::chrono::steady_clock clock;
+    unsigned dispatches = ROUNDS * typeCount * 2;
+    double ns[2];
+    for (int pass = 0; pass < 2; ++pass) {
+        clock::time_point start = clock::now();
+        for (unsigned r = 0; r < ROUNDS; ++r) {
+            for (auto &type : types) {
+                if (pass) {
+                    dispatcher->dispatchEvent(Event::obtain(type));
+                }
+                else {
+                    rbmap.dispatchEvent(Event::obtain(type));
+                }
+            }
+        }
+        ns[pass] = std::chrono::duration<double, std::nano>(clock::now() - start).count() / dispatches;
+    }
+    printf("types %3u listeners %2u  rbmap %6.1f ns  EventDispatcher %6.1f ns  x%.2f%s\n",
+        typeCount, listenerCount, ns[0], ns[1], ns[0] / ns[1], sums[0] == sums[1] ? "" : "  MISMATCH");
+}
+
+int main() {
+    for (unsigned types : {1, 4, 16, 64}) {
+        for (unsigned listeners : {1, 4}) {
+            run(types, listeners);
+        }
+    }
+    return 0;
+}
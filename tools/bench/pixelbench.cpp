@@ -0,0 +1,115 @@
+#include "opengxv.h"
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "gv_pixel.h"
+#include "gv_pixelconvert.h"
+
+using namespace gv;
+
+/* times the pixel conversions of every instruction set the cpu has, as
+ * PixelInfo::convert() runs them: unpacked to RGBA8888 then packed, by
+ * blocks. Each result is checked against the scalar kernels */
+
+enum {
+    PIXELS       = 1 << 20,
+    ROUNDS       = 8,
+    BLOCK_PIXELS = 512,
+};
+
+static const char *formatName(PixelFormat format) {
+    return PixelInfo::get(format)->desc();
+}
+
+static size_t pixelSize(PixelFormat format) {
+    return PixelInfo::get(format)->pixelSize();
+}
+
+/* whether the kernels can convert from to to, the first being RGBA8888
+ * when either is */
+static bool supports(const PixelKernels &kernels, PixelFormat from, PixelFormat to) {
+    if (from == to || (to == PixelFormat::A8 && !PixelInfo::get(from)->alpha())) {
+        return false;
+    }
+    return (from == PixelFormat::RGBA8888 || kernels.unpack[static_cast<size_t>(from)]) &&
+        (to == PixelFormat::RGBA8888 || kernels.pack[static_cast<size_t>(to)]);
+}
+
+static void convert(const PixelKernels &kernels, PixelFormat from, PixelFormat to,
+    const unsigned char *src, unsigned char *dst, size_t count) {
+    if (from == PixelFormat::RGBA8888) {
+        kernels.pack[static_cast<size_t>(to)](src, dst, count);
+        return;
+    }
+    PixelKernel unpack = kernels.unpack[static_cast<size_t>(from)];
+    if (to == PixelFormat::RGBA8888) {
+        unpack(src, dst, count);
+        return;
+    }
+    PixelKernel pack = kernels.pack[static_cast<size_t>(to)];
+    size_t srcSize = pixelSize(from), dstSize = pixelSize(to);
+    unsigned char block[BLOCK_PIXELS * 4];
+    for (size_t i = 0; i < count; i += BLOCK_PIXELS) {
+        size_t n = std::min(count - i, (size_t)BLOCK_PIXELS);
+        unpack(src + i * srcSize, block, n);
+        pack(block, dst + i * dstSize, n);
+    }
+}
+
+int main() {
+    typedef std::chrono::steady_clock clock;
+    const PixelKernels *scalar = pixelKernels(PixelIsa::SCALAR);
+    std::vector<unsigned char> src(PIXELS * 4), dst(PIXELS * 4), expected(PIXELS * 4);
+    srand(1);
+    for (auto &c : src) {
+        c = (unsigned char)rand();
+    }
+
+    // the rate counts the bytes read and written
+    printf("%-6s %-9s %-9s %8s\n", "isa", "from", "to", "GB/s");
+    int failures = 0;
+    for (PixelIsa isa : {PixelIsa::SCALAR, PixelIsa::SSE2, PixelIsa::AVX2, PixelIsa::NEON}) {
+        const PixelKernels *kernels = pixelKernels(isa);
+        if (!kernels) {
+            continue;
+        }
+        for (size_t i = 0; i < static_cast<size_t>(PixelFormat::UNKNOWN); ++i) {
+            for (size_t j = 0; j < static_cast<size_t>(PixelFormat::UNKNOWN); ++j) {
+                PixelFormat from = static_cast<PixelFormat>(i), to = static_cast<PixelFormat>(j);
+                if (!supports(*scalar, from, to)) {
+                    continue;
+                }
+                if (!supports(*kernels, from, to)) {
+                    printf("%-6s %-9s %-9s  missing\n", kernels->name, formatName(from), formatName(to));
+                    ++failures;
+                    continue;
+                }
+
+                clock::time_point start = clock::now();
+                for (unsigned r = 0; r < ROUNDS; ++r) {
+                    convert(*kernels, from, to, src.data(), dst.data(), PIXELS);
+                }
+                double seconds = std::chrono::duration<double>(clock::now() - start).count();
+                double bytes = (double)PIXELS * ROUNDS * (pixelSize(from) + pixelSize(to));
+
+                bool same = true;
+                if (kernels != scalar) {
+                    convert(*scalar, from, to, src.data(), expected.data(), PIXELS);
+                    same = std::equal(dst.begin(), dst.begin() + PIXELS * pixelSize(to), expected.begin());
+                }
+                printf("%-6s %-9s %-9s %8.2f%s\n", kernels->name, formatName(from), formatName(to),
+                    bytes / seconds / 1e9, same ? "" : "  MISMATCH");
+                if (!same) {
+                    ++failures;
+                }
+            }
+        }
+    }
+    if (failures) {
+        printf("%d conversions differ from the scalar kernels.\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,55 @@
+#include "opengxv.h"
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include "gv_object.h"
+
+using namespace gv;
+
+/* times taking and dropping ptr references to an Object, counted with a
+ * plain increment, against a SharedObject, counted with atomics */
+
+enum {
+    COPIES = 1 << 16,
+    ROUNDS = 200,
+};
+
+class Plain : public Object {
+public:
+    int _value = 0;
+};
+
+class Shared : public SharedObject {
+public:
+    int _value = 0;
+};
+
+template <typename _T>
+static void run(const char *name) {
+    typedef std::chrono::steady_clock clock;
+    ptr<_T> obj = object<_T>();
+    std::vector<ptr<_T>> copies;
+    copies.reserve(COPIES);
+
+    double copy = 0, release = 0;
+    for (unsigned r = 0; r < ROUNDS; ++r) {
+        clock::time_point start = clock::now();
+        for (unsigned i = 0; i < COPIES; ++i) {
+            copies.emplace_back(obj);
+        }
+        clock::time_point middle = clock::now();
+        copies.clear();
+        clock::time_point end = clock::now();
+        copy += std::chrono::duration<double, std::nano>(middle - start).count();
+        release += std::chrono::duration<double, std::nano>(end - middle).count();
+    }
+    double count = (double)COPIES * ROUNDS;
+    printf("%-12s copy %5.2f ns  release %5.2f ns  refs left %zu\n",
+        name, copy / count, release / count, ref_count(obj));
+}
+
+int main() {
+    run<Plain>("Object");
+    run<Shared>("SharedObject");
+    return 0;
+}
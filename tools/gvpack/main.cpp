@@ -0,0 +1,258 @@
+#include "opengxv.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#if defined(WIN32) || defined(__MINGW32__)
+#include "windows.h"
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+#include <zlib.h>
+#include "gv_archive.h"
+
+using namespace gv;
+
+struct Item {
+    std::string name;
+    std::vector<unsigned char> data;
+    Archive::Entry entry;
+};
+
+static void usage() {
+    fprintf(stderr, "usage: gvpack [-0] <dir> <archive>\n"
+                    "  packs the files under dir, named by their path relative to it.\n"
+                    "  -0  stores the files without compression.\n");
+}
+
+#if defined(WIN32) || defined(__MINGW32__)
+/* the paths are UTF-8, as the names stored */
+static std::wstring widen(const std::string &str) {
+    WCHAR wszBuf[4096] = { 0 };
+    MultiByteToWideChar(CP_UTF8, 0, str.c_str(), -1, wszBuf, sizeof(wszBuf) / sizeof(wszBuf[0]));
+    return wszBuf;
+}
+
+static std::string narrow(const WCHAR *str) {
+    char szBuf[4096] = { 0 };
+    WideCharToMultiByte(CP_UTF8, 0, str, -1, szBuf, sizeof(szBuf), NULL, NULL);
+    return szBuf;
+}
+
+static FILE *openFile(const std::string &path, bool write) {
+    return _wfopen(widen(path).c_str(), write ? L"wb" : L"rb");
+}
+
+static void removeFile(const std::string &path) {
+    _wremove(widen(path).c_str());
+}
+
+/* calls fn(name, directory) for each entry of dir, false if dir can't
+ * be opened */
+template <typename _Fn>
+static bool listDir(const std::string &dir, const _Fn &fn) {
+    WIN32_FIND_DATAW data;
+    HANDLE handle = ::FindFirstFileW(widen(dir + "/*").c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    do {
+        fn(narrow(data.cFileName), (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0);
+    } while (::FindNextFileW(handle, &data));
+    ::FindClose(handle);
+    return true;
+}
+#else
+static FILE *openFile(const std::string &path, bool write) {
+    return fopen(path.c_str(), write ? "wb" : "rb");
+}
+
+static void removeFile(const std::string &path) {
+    remove(path.c_str());
+}
+
+/* calls fn(name, directory) for each directory and regular file in dir,
+ * false if dir can't be opened */
+template <typename _Fn>
+static bool listDir(const std::string &dir, const _Fn &fn) {
+    DIR *d = opendir(dir.c_str());
+    if (!d) {
+        return false;
+    }
+    while (struct dirent *ent = readdir(d)) {
+        std::string path = dir + "/" + ent->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) < 0 || !(S_ISDIR(st.st_mode) || S_ISREG(st.st_mode))) {
+            continue;
+        }
+        fn(std::string(ent->d_name), S_ISDIR(st.st_mode));
+    }
+    closedir(d);
+    return true;
+}
+#endif
+
+static bool readFile(const std::string &path, std::vector<unsigned char> &data) {
+    FILE *fp = openFile(path, false);
+    if (!fp) {
+        return false;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data.resize(size > 0 ? (size_t)size : 0);
+    bool ok = size >= 0 && fread(data.data(), 1, data.size(), fp) == data.size();
+    fclose(fp);
+    return ok;
+}
+
+static bool scan(const std::string &dir, const std::string &prefix, std::vector<Item> &items) {
+    bool ok = true;
+    bool opened = listDir(dir, [&](const std::string &entry, bool directory) {
+        if (entry[0] == '.') {
+            return;
+        }
+        std::string path = dir + "/" + entry;
+        std::string name = prefix + entry;
+        if (directory) {
+            ok = scan(path, name + "/", items) && ok;
+        }
+        else {
+            items.emplace_back();
+            items.back().name = name;
+            if (!readFile(path, items.back().data)) {
+                fprintf(stderr, "can't read '%s'.\n", path.c_str());
+                ok = false;
+            }
+        }
+    });
+    if (!opened) {
+        fprintf(stderr, "can't open directory '%s'.\n", dir.c_str());
+        return false;
+    }
+    return ok;
+}
+
+static void pad(std::vector<unsigned char> &out, size_t alignment) {
+    out.resize((out.size() + alignment - 1) / alignment * alignment);
+}
+
+template <typename _T>
+static void append(std::vector<unsigned char> &out, const _T *data, size_t count) {
+    const unsigned char *p = (const unsigned char*)data;
+    out.insert(out.end(), p, p + count * sizeof(_T));
+}
+
+int main(int argc, char *argv[]) {
+    bool deflate = true;
+    int arg = 1;
+    if (arg < argc && !strcmp(argv[arg], "-0")) {
+        deflate = false;
+        ++arg;
+    }
+    if (argc - arg != 2) {
+        usage();
+        return 1;
+    }
+    std::string dir = argv[arg];
+    std::string output = argv[arg + 1];
+
+    std::vector<Item> items;
+    if (!scan(dir, "", items)) {
+        return 1;
+    }
+    std::sort(items.begin(), items.end(), [](const Item &lhs, const Item &rhs) {
+        return lhs.name < rhs.name;
+    });
+
+    std::vector<unsigned char> out(sizeof(Archive::Header));
+    std::string names;
+    size_t stored = 0, packed = 0;
+
+    for (auto &item : items) {
+        Archive::Entry &entry = item.entry;
+        memset(&entry, 0, sizeof(entry));
+        entry.hash = Archive::hash(item.name.data(), item.name.size());
+        entry.size = item.data.size();
+        entry.name = (uint32_t)names.size();
+        entry.nameSize = (uint32_t)item.name.size();
+        names += item.name;
+
+        // a stored entry is loaded as a slice of the mapping, so it is
+        // only deflated when that saves at least an eighth
+        std::vector<unsigned char> buf;
+        if (deflate && !item.data.empty()) {
+            uLongf size = compressBound(item.data.size());
+            buf.resize(size);
+            if (compress2(buf.data(), &size, item.data.data(), item.data.size(), Z_BEST_COMPRESSION) == Z_OK &&
+                size < item.data.size() - item.data.size() / 8) {
+                buf.resize(size);
+                entry.flags |= Archive::DEFLATED;
+            }
+        }
+        const std::vector<unsigned char> &payload = entry.flags & Archive::DEFLATED ? buf : item.data;
+
+        pad(out, Archive::ALIGNMENT);
+        entry.offset = out.size();
+        entry.packedSize = payload.size();
+        append(out, payload.data(), payload.size());
+        stored += item.data.size();
+        packed += payload.size();
+    }
+
+    Archive::Header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = Archive::MAGIC;
+    header.version = Archive::VERSION;
+    header.count = (uint32_t)items.size();
+    header.slots = 1;
+    while (header.slots < header.count * 2) {
+        header.slots <<= 1;
+    }
+    if (header.slots <= header.count) {
+        header.slots <<= 1;
+    }
+
+    pad(out, Archive::ALIGNMENT);
+    header.entries = out.size();
+    std::vector<uint32_t> slots(header.slots);
+    for (size_t i = 0; i < items.size(); ++i) {
+        const Archive::Entry &entry = items[i].entry;
+        append(out, &entry, 1);
+
+        uint32_t mask = header.slots - 1;
+        uint32_t slot = (uint32_t)entry.hash & mask;
+        while (slots[slot]) {
+            const Archive::Entry &other = items[slots[slot] - 1].entry;
+            if (other.hash == entry.hash) {
+                fprintf(stderr, "hash collision between '%s' and '%s'.\n",
+                    items[slots[slot] - 1].name.c_str(), items[i].name.c_str());
+            }
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = (uint32_t)i + 1;
+    }
+    append(out, slots.data(), slots.size());
+    header.names = out.size();
+    append(out, names.data(), names.size());
+    memcpy(out.data(), &header, sizeof(header));
+
+    FILE *fp = openFile(output, true);
+    if (!fp) {
+        fprintf(stderr, "can't create '%s'.\n", output.c_str());
+        return 1;
+    }
+    bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) {
+        fprintf(stderr, "can't write '%s'.\n", output.c_str());
+        removeFile(output);
+        return 1;
+    }
+    printf("%u files, %zu bytes, %zu packed, archive %zu bytes.\n",
+        header.count, stored, packed, out.size());
+    return 0;
+}
+